@@ -0,0 +1,367 @@
+// Benchmark suite for stl2obj
+
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include <getopt.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "meshgen.h"
+#include "../src/geometry.h"
+#include "../src/importstl.h"
+#include "../src/exportobj.h"
+#include "../src/kdtree.h"
+#include "../src/simdkernels.h"
+#include "../src/weld.h"
+
+static const char* PROGRAM_NAME = "stl2obj_bench";
+
+// swallows the progress messages of the importer and exporter
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+};
+
+struct Result {
+    std::string mesh;
+    size_t triangles;
+    std::string stage;
+    double seconds;     // fastest of the repetitions
+    double median;      // median of the repetitions
+    size_t items;
+    const char* unit;
+};
+
+struct Bench {
+    unsigned repeat = 3;
+    unsigned threads = 0;
+    WeldMethod importWeld = WeldMethod::SORT;
+    double tolerance = 1.0e-6;
+    std::string tempDir;
+    std::vector<Result> results;
+
+//  run "fn" "repeat" times and record the fastest and the median time
+    template <typename Fn>
+    void measure(const std::string& mesh, size_t triangles,
+        const std::string& stage, size_t items, const char* unit, Fn fn)
+    {
+        std::vector<double> times;
+        for (unsigned r = 0; r < repeat; r++) {
+            auto t0 = std::chrono::steady_clock::now();
+            fn();
+            std::chrono::duration<double> duration =
+                std::chrono::steady_clock::now() - t0;
+            times.push_back(duration.count());
+        }
+        std::sort(times.begin(), times.end());
+        results.push_back({mesh, triangles, stage, times.front(),
+            times[times.size() / 2], items, unit});
+        fprintf(stderr, "%-8s %10zu  %-14s %10.4f s\n", mesh.c_str(),
+            triangles, stage.c_str(), times.front());
+    }
+
+    void run(const std::string& mesh, const std::vector<float>& tris);
+    void print(FILE* out) const;
+};
+
+// write a binary STL file with zero normals
+static void writeSTL(const std::string& filename,
+    const std::vector<float>& tris)
+{
+    std::ofstream file(filename, std::ios::binary);
+    char header[80] = "stl2obj benchmark";
+    file.write(header, sizeof(header));
+    uint32_t numOfTris = tris.size() / 9;
+    file.write((const char*)&numOfTris, sizeof(numOfTris));
+    const float normal[3] = {0.0f, 0.0f, 0.0f};
+    const uint16_t attribute = 0;
+    for (size_t i = 0; i < numOfTris; i++) {
+        file.write((const char*)normal, sizeof(normal));
+        file.write((const char*)&tris[9 * i], 9 * sizeof(float));
+        file.write((const char*)&attribute, sizeof(attribute));
+    }
+    if (!file) throw std::runtime_error("cannot write \"" + filename + "\"");
+}
+
+static size_t fileSize(const std::string& filename)
+{
+    struct stat st;
+    return (stat(filename.c_str(), &st) == 0) ? st.st_size : 0;
+}
+
+void Bench::run(const std::string& mesh, const std::vector<float>& tris)
+{
+    using Point = Geometry::Point;
+    const TriangleSoup soup((const char*)tris.data(), 9 * sizeof(float),
+        tris.size() / 9);
+    const size_t numOfTris = soup.numOfTris();
+
+    const std::pair<const char*, WeldMethod> methods[] = {
+        {"weld.kdtree", WeldMethod::KDTREE},
+        {"weld.grid", WeldMethod::GRID},
+        {"weld.sort", WeldMethod::SORT}
+    };
+    for (const auto& method : methods) {
+        WeldOptions options;
+        options.method = method.second;
+        options.tolerance = tolerance;
+        options.threads = threads;
+        measure(mesh, numOfTris, method.first, soup.size(), "corners", [&] {
+            Geometry model;
+            weld(soup, options, model);
+        });
+    }
+
+//  a welded model and the corners as queries for the remaining stages
+    WeldOptions options;
+    options.method = importWeld;
+    options.tolerance = tolerance;
+    options.threads = threads;
+    Geometry model;
+    weld(soup, options, model);
+    std::vector<Point> points(model.verts_.size());
+    for (size_t i = 0; i < points.size(); i++) points[i] = model.verts_[i];
+    std::vector<Point> queries(soup.size());
+    for (size_t i = 0; i < queries.size(); i++) {
+        queries[i] = soup.corner<Geometry::Real>(i);
+    }
+
+    std::string stlFile = tempDir + "/" + PROGRAM_NAME + "_" + mesh + ".stl";
+    std::string objFile = tempDir + "/" + PROGRAM_NAME + "_" + mesh + ".obj";
+    writeSTL(stlFile, tris);
+
+    NullBuffer null;
+    std::streambuf* cout = std::cout.rdbuf(&null);
+    try {
+        measure(mesh, numOfTris, "import", fileSize(stlFile), "bytes", [&] {
+            Geometry imported;
+            imported.visit(ImportSTL(stlFile, false, options));
+        });
+        ExportOBJ(objFile, 0, threads).save(model);
+        measure(mesh, numOfTris, "export", fileSize(objFile), "bytes", [&] {
+            ExportOBJ(objFile, 0, threads).save(model);
+        });
+    } catch (...) {
+        std::cout.rdbuf(cout);
+        unlink(stlFile.c_str());
+        unlink(objFile.c_str());
+        throw;
+    }
+    std::cout.rdbuf(cout);
+    unlink(stlFile.c_str());
+    unlink(objFile.c_str());
+
+    measure(mesh, numOfTris, "kdtree.build", points.size(), "points", [&] {
+        KDTree<3, Geometry::Real> tree(points, threads);
+    });
+    KDTree<3, Geometry::Real> tree(points, threads);
+    std::vector<int> found(queries.size());
+    measure(mesh, numOfTris, "kdtree.query", queries.size(), "queries", [&] {
+        for (size_t i = 0; i < queries.size(); i++) {
+            found[i] = tree.findNearest(queries[i]);
+        }
+    });
+    measure(mesh, numOfTris, "kdtree.batch", queries.size(), "queries", [&] {
+        tree.findNearestBatch(queries.data(), queries.size(), found.data(),
+            threads);
+    });
+
+//  batch kernels on their own: the bounding box of the soup, and distances
+//  from a few queries to all vertices stored axis by axis
+    measure(mesh, numOfTris, "simd.bounds", soup.size(), "corners", [&] {
+        float lo[3], hi[3];
+        soup.bounds(0, numOfTris, lo, hi);
+    });
+    std::vector<Geometry::Real> axes[3], dist(points.size());
+    for (unsigned a = 0; a < 3; a++) {
+        for (const Point& p : points) axes[a].push_back(p[a]);
+    }
+    const size_t numOfQueries = 16;
+    measure(mesh, numOfTris, "simd.dist_sqr", numOfQueries * points.size(),
+        "points", [&] {
+        for (size_t q = 0; q < numOfQueries; q++) {
+            Point p = queries[q * queries.size() / numOfQueries];
+            const Geometry::Real center[3] = {p[0], p[1], p[2]};
+            distSqrBatch(axes[0].data(), axes[1].data(), axes[2].data(),
+                points.size(), center, dist.data());
+        }
+    });
+}
+
+// one JSON object with the configuration and a flat list of results
+void Bench::print(FILE* out) const
+{
+    fprintf(out, "{\n");
+    fprintf(out, "  \"precision\": \"%s\",\n",
+        sizeof(Geometry::Real) == sizeof(float) ? "float" : "double");
+#ifdef STL2OBJ_SOA
+    fprintf(out, "  \"layout\": \"SOA\",\n");
+#else
+    fprintf(out, "  \"layout\": \"AOS\",\n");
+#endif
+    fprintf(out, "  \"simd\": \"%s\",\n", simdLevel());
+    fprintf(out, "  \"threads\": %u,\n", threads);
+    fprintf(out, "  \"repeat\": %u,\n", repeat);
+    fprintf(out, "  \"tolerance\": %g,\n", tolerance);
+    fprintf(out, "  \"results\": [");
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        fprintf(out, "%s\n    {\"mesh\": \"%s\", \"triangles\": %zu, "
+            "\"stage\": \"%s\", \"seconds\": %.6f, \"median\": %.6f, "
+            "\"items\": %zu, \"unit\": \"%s\", \"per_second\": %.1f}",
+            i ? "," : "", r.mesh.c_str(), r.triangles, r.stage.c_str(),
+            r.seconds, r.median, r.items, r.unit,
+            r.seconds > 0.0 ? r.items / r.seconds : 0.0);
+    }
+    fprintf(out, "\n  ]\n}\n");
+}
+
+void usage(int status)
+{
+    printf("Usage: %s [OPTION]...\n", PROGRAM_NAME);
+    printf("Times the stages of stl2obj on synthetic meshes and prints the "
+        "results as JSON.\n");
+    printf(
+        "Options:\n"
+        "  -n, --sizes=N,N,...      triangle counts (default: 10000,100000)\n"
+        "  -m, --meshes=NAME,...    sphere, terrain and/or soup (default:\n"
+        "                           all)\n"
+        "  -r, --repeat=N           repetitions per measurement (default: 3)\n"
+        "  -j, --threads=N          number of worker threads (default: all)\n"
+        "  -w, --weld=METHOD        welding method of the import stage:\n"
+        "                           kdtree, grid or sort (default)\n"
+        "  -o, --output=FILE        write the JSON to FILE instead of\n"
+        "                           stdout\n");
+    exit(status);
+}
+
+// split a comma-separated list
+static std::vector<std::string> split(const char* str)
+{
+    std::vector<std::string> items;
+    std::string item;
+    for (const char* p = str; ; p++) {
+        if (*p == ',' || *p == '\0') {
+            if (!item.empty()) items.push_back(item);
+            item.clear();
+            if (*p == '\0') break;
+        } else {
+            item += *p;
+        }
+    }
+    return items;
+}
+
+int main(int argc, char** argv)
+{
+    static struct option const long_options[] = {
+        {"sizes", required_argument, NULL, 'n'},
+        {"meshes", required_argument, NULL, 'm'},
+        {"repeat", required_argument, NULL, 'r'},
+        {"threads", required_argument, NULL, 'j'},
+        {"weld", required_argument, NULL, 'w'},
+        {"output", required_argument, NULL, 'o'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+
+    Bench bench;
+    std::vector<std::string> sizes = {"10000", "100000"};
+    std::vector<std::string> meshes = {"sphere", "terrain", "soup"};
+    const char* output = NULL;
+
+    int c;
+    while ((c = getopt_long(argc, argv, "n:m:r:j:w:o:h", long_options,
+        NULL)) != -1) {
+        switch (c) {
+        case 'n':
+            sizes = split(optarg);
+            break;
+        case 'm':
+            meshes = split(optarg);
+            break;
+        case 'r':
+            bench.repeat = std::max(1, atoi(optarg));
+            break;
+        case 'j':
+            bench.threads = atoi(optarg);
+            break;
+        case 'w':
+            if (strcmp(optarg, "kdtree") == 0) {
+                bench.importWeld = WeldMethod::KDTREE;
+            } else if (strcmp(optarg, "grid") == 0) {
+                bench.importWeld = WeldMethod::GRID;
+            } else if (strcmp(optarg, "sort") == 0) {
+                bench.importWeld = WeldMethod::SORT;
+            } else {
+                usage(EXIT_FAILURE);
+            }
+            break;
+        case 'o':
+            output = optarg;
+            break;
+        case 'h':
+            usage(EXIT_SUCCESS);
+            break;
+        default:
+            usage(EXIT_FAILURE);
+        }
+    }
+
+    const char* tmp = getenv("TMPDIR");
+    bench.tempDir = (tmp && *tmp) ? tmp : "/tmp";
+
+    try {
+        for (const std::string& size : sizes) {
+            size_t numOfTris = strtoull(size.c_str(), NULL, 10);
+            for (const std::string& mesh : meshes) {
+                if (mesh == "sphere") {
+                    bench.run(mesh, makeSphere(numOfTris));
+                } else if (mesh == "terrain") {
+                    bench.run(mesh, makeTerrain(numOfTris));
+                } else if (mesh == "soup") {
+                    bench.run(mesh, makeNoisySoup(numOfTris));
+                } else {
+                    throw std::runtime_error("unknown mesh \"" + mesh + "\"");
+                }
+            }
+        }
+    } catch (const std::exception& e) {
+        fprintf(stderr, "%s: %s\n", PROGRAM_NAME, e.what());
+        return EXIT_FAILURE;
+    }
+
+    FILE* out = output ? fopen(output, "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "%s: cannot open \"%s\"\n", PROGRAM_NAME, output);
+        return EXIT_FAILURE;
+    }
+    bench.print(out);
+    if (out != stdout) fclose(out);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,129 @@
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TYPE_MESHGEN_H_
+#define TYPE_MESHGEN_H_
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+// Synthetic triangle soups for benchmarking. Every generator returns 9
+// floats (three corners) per triangle, which is the layout TriangleSoup
+// reads with a stride of 36 bytes, and produces about "numOfTris"
+// triangles. The meshes only depend on their arguments, so results are
+// comparable between runs and machines.
+
+// append the corners of triangle (a, b, c)
+static inline void addTriangle(std::vector<float>& tris, const float* a,
+    const float* b, const float* c)
+{
+    tris.insert(tris.end(), a, a + 3);
+    tris.insert(tris.end(), b, b + 3);
+    tris.insert(tris.end(), c, c + 3);
+}
+
+// Unit sphere tessellated in latitude/longitude bands, band by band. Every
+// interior vertex is shared by six triangles, like a typical closed CAD
+// part; the triangles at the poles are degenerate.
+inline std::vector<float> makeSphere(size_t numOfTris)
+{
+    const double PI = 3.14159265358979323846;
+    size_t rings = std::max<size_t>(2, (size_t)std::sqrt(numOfTris / 4.0));
+    size_t segments = std::max<size_t>(3, numOfTris / (2 * rings));
+    auto point = [&](size_t i, size_t j, float* p) {
+        double theta = PI * i / rings, phi = 2.0 * PI * (j % segments) /
+            segments;
+        p[0] = (float)(std::sin(theta) * std::cos(phi));
+        p[1] = (float)(std::sin(theta) * std::sin(phi));
+        p[2] = (float)std::cos(theta);
+    };
+    std::vector<float> tris;
+    tris.reserve(9 * 2 * rings * segments);
+    float a[3], b[3], c[3], d[3];
+    for (size_t i = 0; i < rings; i++) {
+        for (size_t j = 0; j < segments; j++) {
+            point(i, j, a);
+            point(i + 1, j, b);
+            point(i + 1, j + 1, c);
+            point(i, j + 1, d);
+            addTriangle(tris, a, b, c);
+            addTriangle(tris, a, c, d);
+        }
+    }
+    return tris;
+}
+
+// Height field over the unit square, emitted row by row. The corners arrive
+// sorted along y and then x, which is the worst case for structures that
+// are built by inserting points one at a time.
+inline std::vector<float> makeTerrain(size_t numOfTris)
+{
+    size_t side = std::max<size_t>(1, (size_t)std::sqrt(numOfTris / 2.0));
+    auto point = [&](size_t i, size_t j, float* p) {
+        double x = (double)j / side, y = (double)i / side;
+        p[0] = (float)x;
+        p[1] = (float)y;
+        p[2] = (float)(0.1 * std::sin(12.0 * x) * std::cos(9.0 * y));
+    };
+    std::vector<float> tris;
+    tris.reserve(9 * 2 * side * side);
+    float a[3], b[3], c[3], d[3];
+    for (size_t i = 0; i < side; i++) {
+        for (size_t j = 0; j < side; j++) {
+            point(i, j, a);
+            point(i, j + 1, b);
+            point(i + 1, j + 1, c);
+            point(i + 1, j, d);
+            addTriangle(tris, a, b, c);
+            addTriangle(tris, a, c, d);
+        }
+    }
+    return tris;
+}
+
+// The sphere with its triangles in random order and every corner moved by
+// up to "ulps" units in the last place on each axis. Copies of a vertex are
+// then near duplicates rather than exact ones, which defeats exact-match
+// shortcuts; a tolerance of 1e-6 merges them again.
+inline std::vector<float> makeNoisySoup(size_t numOfTris, int ulps = 2,
+    uint64_t seed = 12345)
+{
+    std::vector<float> sphere = makeSphere(numOfTris);
+    size_t n = sphere.size() / 9;
+    std::vector<size_t> order(n);
+    for (size_t i = 0; i < n; i++) order[i] = i;
+    std::mt19937_64 rng(seed);
+    std::shuffle(order.begin(), order.end(), rng);
+    std::uniform_int_distribution<int> jitter(-ulps, ulps);
+
+    std::vector<float> tris(sphere.size());
+    for (size_t i = 0; i < n; i++) {
+        for (size_t k = 0; k < 9; k++) {
+            float v = sphere[9 * order[i] + k];
+            for (int s = jitter(rng); s != 0; s += (s < 0) ? 1 : -1) {
+                v = std::nextafter(v, (s < 0) ? -2.0f : 2.0f);
+            }
+            tris[9 * i + k] = v;
+        }
+    }
+    return tris;
+}
+
+#endif // TYPE_MESHGEN_H_
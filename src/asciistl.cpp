@@ -0,0 +1,124 @@
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include "asciistl.h"
+#include "parallel.h"
+
+static bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' ||
+        c == '\v';
+}
+
+bool isAsciiSTL(const char* data, size_t size)
+{
+    return isAsciiSTL(data, size, size);
+}
+
+bool isAsciiSTL(const char* data, size_t size, uint64_t fileSize)
+{
+    size_t pos = 0;
+    while (pos < size && isSpace(data[pos])) pos++;
+    if (size - pos < 5 || std::memcmp(data + pos, "solid", 5) != 0) {
+        return false;
+    }
+    if (fileSize < 84 || size < 84) return true;
+    uint32_t numOfTris;
+    std::memcpy(&numOfTris, data + 80, sizeof(uint32_t));
+    return fileSize != 84 + 50 * (uint64_t)numOfTris;
+}
+
+//  Parse all "vertex x y z" lines in [begin, end). Every other keyword and
+//  number (facet normals included) is skipped, and "solid"/"endsolid" lines
+//  are skipped as a whole because they may carry a free-form name.
+static void parseChunk(const char* begin, const char* end,
+    std::vector<float>& coords)
+{
+    const char* ptr = begin;
+    while (ptr < end) {
+        while (ptr < end && isSpace(*ptr)) ptr++;
+        const char* token = ptr;
+        while (ptr < end && !isSpace(*ptr)) ptr++;
+        std::string_view word(token, ptr - token);
+
+        if (word == "solid" || word == "endsolid") {
+            while (ptr < end && *ptr != '\n') ptr++;
+        } else if (word == "vertex") {
+            for (int a = 0; a < 3; a++) {
+                while (ptr < end && isSpace(*ptr)) ptr++;
+//              from_chars doesn't accept an explicit plus sign
+                if (ptr < end && *ptr == '+') ptr++;
+                float value;
+                auto result = std::from_chars(ptr, end, value);
+                if (result.ec != std::errc()) {
+                    throw std::runtime_error("malformed vertex in ASCII STL "
+                        "near \"" + std::string(token,
+                        std::min<size_t>(end - token, 40)) + "\"");
+                }
+                coords.push_back(value);
+                ptr = result.ptr;
+            }
+        }
+    }
+}
+
+std::vector<float> parseAsciiSTL(const char* data, size_t size,
+    unsigned threads)
+{
+    const std::string_view text(data, size);
+    const std::string_view ENDFACET("endfacet");
+
+//  Move the nominal chunk boundaries to just past the next "endfacet", so
+//  that every facet is parsed by exactly one chunk. Neighbouring boundaries
+//  may collapse into one, leaving some chunks empty.
+    unsigned chunks = chunkCount(size, threads, 1 << 20);
+    std::vector<size_t> bound(chunks + 1, size);
+    bound[0] = 0;
+    for (unsigned c = 1; c < chunks; c++) {
+        size_t pos = text.find(ENDFACET, std::max(chunkBegin(size, chunks, c),
+            bound[c - 1]));
+        bound[c] = (pos == std::string_view::npos) ? size
+            : pos + ENDFACET.size();
+    }
+
+    std::vector<std::vector<float>> parts(chunks);
+    parallelChunks(chunks, chunks, [&](unsigned c, size_t, size_t) {
+//      about 250 bytes of text per facet
+        parts[c].reserve((bound[c + 1] - bound[c]) / 250 * 9);
+        parseChunk(data + bound[c], data + bound[c + 1], parts[c]);
+        if (parts[c].size() % 9 != 0) {
+            throw std::runtime_error("ASCII STL facet without three vertices");
+        }
+    });
+
+    if (chunks == 1) return std::move(parts[0]);
+    std::vector<size_t> offset(chunks + 1, 0);
+    for (unsigned c = 0; c < chunks; c++) {
+        offset[c + 1] = offset[c] + parts[c].size();
+    }
+    std::vector<float> coords(offset[chunks]);
+    parallelChunks(chunks, chunks, [&](unsigned c, size_t, size_t) {
+        std::copy(parts[c].begin(), parts[c].end(), coords.begin() + offset[c]);
+        std::vector<float>().swap(parts[c]);
+    });
+    return coords;
+}
@@ -0,0 +1,40 @@
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TYPE_ASCIISTL_H_
+#define TYPE_ASCIISTL_H_
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Return true if the buffer holds an ASCII STL file. Some binary files also
+// start with "solid", so those only count as ASCII if their size doesn't
+// match the triangle count of a binary header.
+bool isAsciiSTL(const char* data, size_t size);
+
+// Same test when only the first "size" bytes of a file of "fileSize" bytes
+// are at hand; the first 84 bytes (or the whole file) are enough.
+bool isAsciiSTL(const char* data, size_t size, uint64_t fileSize);
+
+// Parse the facets of an ASCII STL file into 9 floats (three corners) per
+// triangle. The text is split into chunks at "endfacet" boundaries, and the
+// chunks are parsed on "threads" threads (0 means all cores). Throws
+// std::runtime_error if a vertex can't be parsed.
+std::vector<float> parseAsciiSTL(const char* data, size_t size,
+    unsigned threads);
+
+#endif // TYPE_ASCIISTL_H_
@@ -0,0 +1,280 @@
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <condition_variable>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <streambuf>
+#include <thread>
+#include "batchconvert.h"
+#include "geometry.h"
+#include "importstl.h"
+#include "exportobj.h"
+#include "exportply.h"
+#include "streamconvert.h"
+#include "pipelineconvert.h"
+#include "convertcache.h"
+#include "gzip.h"
+#include "inputfile.h"
+#include "parallel.h"
+#include "profiler.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// discards everything written to it
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize n) override {
+        return n;
+    }
+};
+
+// points std::cout at a NullBuffer for its lifetime
+class MuteCout {
+    NullBuffer null_;
+    std::streambuf* saved_;
+public:
+    MuteCout() : saved_(std::cout.rdbuf(&null_)) {}
+    ~MuteCout() { std::cout.rdbuf(saved_); }
+};
+
+// Admits jobs while the sum of their estimates stays within the limit.
+// With nothing running, any job is admitted, so a job larger than the
+// limit still runs, only alone.
+class MemoryGate {
+    std::mutex mutex_;
+    std::condition_variable released_;
+    size_t limit_;
+    size_t inUse_ = 0;
+    unsigned running_ = 0;
+public:
+    explicit MemoryGate(size_t limit) : limit_(limit) {}
+
+    void acquire(size_t bytes) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        released_.wait(lock, [&] {
+            return limit_ == 0 || running_ == 0 || inUse_ + bytes <= limit_;
+        });
+        inUse_ += bytes;
+        running_++;
+    }
+
+    void release(size_t bytes) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            inUse_ -= bytes;
+            running_--;
+        }
+        released_.notify_all();
+    }
+};
+
+} // namespace
+
+BatchConvert::BatchConvert(const Options& options) : options_(options) {}
+
+// convert one file; returns true if the output came from the cache
+bool BatchConvert::convert(const BatchJob& job) const
+{
+    auto convert = [&] {
+        if (options_.memoryBudget > 0) {
+            StreamConvert::Options options;
+            options.memoryBudget = options_.memoryBudget;
+            options.tolerance = options_.weld.tolerance;
+            options.precision = options_.precision;
+            options.threads = options_.weld.threads;
+            StreamConvert(options).convert(job.input, job.output);
+            return;
+        }
+        if (options_.pipelined) {
+            PipelineConvert::Options options;
+            options.tolerance = options_.weld.tolerance;
+            options.precision = options_.precision;
+            options.threads = options_.weld.threads;
+            PipelineConvert(options).convert(job.input, job.output);
+            return;
+        }
+        Geometry model;
+        model.visit(ImportSTL(job.input, options_.mapped, options_.weld));
+        runMeshPasses(model, options_.passes, options_.weld.threads);
+        if (isPLYFile(job.output)) {
+            model.visit(ExportPLY(job.output, options_.weld.threads));
+        } else {
+            model.visit(ExportOBJ(job.output, options_.precision,
+                options_.weld.threads));
+        }
+    };
+    if (options_.cacheDir.empty()) {
+        convert();
+        return false;
+    }
+    ConvertCache cache(options_.cacheDir, options_.cacheSize);
+    return cache.convert(job.input, cacheTag(options_.weld,
+        options_.precision, options_.memoryBudget > 0, options_.passes),
+        job.output, convert);
+}
+
+//  Peak memory of an in-memory conversion is about three times the size of
+//  a binary STL file: the file itself, the scratch arrays of the welder and
+//  the indexed mesh. ASCII files need less relative to their size. The
+//  size of a compressed file is that of its contents, as recorded in the
+//  gzip trailer (modulo 4 GiB, so at least the size on disk is assumed).
+//  An out-of-core conversion stays within its budget.
+size_t BatchConvert::estimateMemory(const BatchJob& job) const
+{
+    if (options_.memoryBudget > 0) {
+        return std::max<size_t>(options_.memoryBudget, 16 << 20);
+    }
+    std::error_code error;
+    uintmax_t size = fs::file_size(job.input, error);
+    if (error) return 0;
+    try {
+        InputFile file(job.input);
+        if (file.compressed()) size = std::max<uintmax_t>(size, file.size());
+    } catch (const std::exception&) {
+//      the conversion reports the error
+    }
+    return 3 * (size_t)size;
+}
+
+std::vector<BatchConvert::Result> BatchConvert::run(
+    const std::vector<BatchJob>& jobs)
+{
+    std::vector<Result> results(jobs.size());
+    std::atomic<size_t> next(0);
+    std::mutex report;
+    size_t done = 0;
+    MemoryGate gate(options_.memoryLimit);
+    MuteCout mute;
+
+    auto worker = [&] {
+        for (size_t i = next++; i < jobs.size(); i = next++) {
+            Result& result = results[i];
+            result.job = jobs[i];
+            size_t memory = estimateMemory(jobs[i]);
+            gate.acquire(memory);
+            ProfileStage stage("convert");
+            try {
+                result.cached = convert(jobs[i]);
+                result.ok = true;
+            } catch (const std::exception& e) {
+                result.error = e.what();
+            }
+            result.seconds = stage.stop();
+            gate.release(memory);
+
+            std::lock_guard<std::mutex> lock(report);
+            done++;
+            if (result.ok) {
+                printf("[%zu/%zu] %s -> %s (%.3f s%s)\n", done, jobs.size(),
+                    jobs[i].input.c_str(), jobs[i].output.c_str(),
+                    result.seconds, result.cached ? ", cached" : "");
+            } else {
+                printf("[%zu/%zu] %s failed\n", done, jobs.size(),
+                    jobs[i].input.c_str());
+                fprintf(stderr, "%s: %s\n", jobs[i].input.c_str(),
+                    result.error.c_str());
+            }
+            fflush(stdout);
+        }
+    };
+
+    unsigned workers = std::min<size_t>(resolveThreads(options_.workers),
+        std::max<size_t>(jobs.size(), 1));
+//  the profiler is per thread; the pool threads record into their own
+//  and are merged into the caller's once they are done
+    Profiler* profiler = Profiler::current();
+    std::vector<std::unique_ptr<Profiler>> profilers;
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < workers; t++) {
+        Profiler* own = nullptr;
+        if (profiler) {
+            profilers.emplace_back(new Profiler);
+            own = profilers.back().get();
+        }
+        pool.emplace_back([&worker, own] {
+            Profiler::install(own);
+            worker();
+        });
+    }
+    worker();
+    for (auto& t : pool) t.join();
+    for (const auto& own : profilers) profiler->merge(*own);
+    return results;
+}
+
+static std::string objName(const fs::path& input)
+{
+    fs::path output = stripGzipSuffix(input.string());
+    return output.replace_extension(".obj").string();
+}
+
+static std::string trim(const std::string& str)
+{
+    const char* space = " \t\r\n";
+    size_t first = str.find_first_not_of(space);
+    if (first == std::string::npos) return std::string();
+    return str.substr(first, str.find_last_not_of(space) - first + 1);
+}
+
+std::vector<BatchJob> readManifest(const std::string& filename)
+{
+    std::ifstream file(filename);
+    if (!file) throw std::runtime_error("cannot open \"" + filename + "\"");
+    std::vector<BatchJob> jobs;
+    std::string line;
+    while (std::getline(file, line)) {
+        line = trim(line);
+        if (line.empty() || line[0] == '#') continue;
+        size_t split = line.find('\t');
+        if (split == std::string::npos) split = line.find_first_of(" ");
+        BatchJob job;
+        job.input = trim(line.substr(0, split));
+        if (split != std::string::npos) job.output = trim(line.substr(split));
+        if (job.output.empty()) job.output = objName(job.input);
+        jobs.push_back(job);
+    }
+    return jobs;
+}
+
+std::vector<BatchJob> listDirectory(const std::string& directory,
+    const std::string& outputDir)
+{
+    fs::path target = outputDir.empty() ? directory : outputDir;
+    std::vector<BatchJob> jobs;
+    for (const auto& entry : fs::directory_iterator(directory)) {
+        if (!entry.is_regular_file()) continue;
+        fs::path name = stripGzipSuffix(entry.path().string());
+        std::string ext = name.extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        if (ext != ".stl") continue;
+        jobs.push_back(BatchJob{entry.path().string(),
+            objName(target / entry.path().filename())});
+    }
+    std::sort(jobs.begin(), jobs.end(),
+        [](const BatchJob& a, const BatchJob& b) { return a.input < b.input; });
+    return jobs;
+}
@@ -0,0 +1,101 @@
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TYPE_BATCHCONVERT_H_
+#define TYPE_BATCHCONVERT_H_
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "weld.h"
+#include "meshpasses.h"
+
+// one file to convert
+struct BatchJob {
+    std::string input;
+    std::string output;
+};
+
+// Converts many files in one process. Conversions run concurrently on a
+// fixed pool of worker threads, each of which converts one file at a time
+// single-threaded, so the machine is kept busy by files rather than by the
+// stages of a single file. A job only starts once its estimated memory
+// fits within the limit next to the jobs that are already running; a job
+// that doesn't fit at all runs on its own. A failed conversion is reported
+// and the batch moves on.
+class BatchConvert {
+public:
+    struct Options {
+//      number of concurrent conversions; 0 means one per core
+        unsigned workers = 0;
+//      bound on the estimated memory of the running conversions, in
+//      bytes; 0 means no bound
+        size_t memoryLimit = 0;
+//      read binary STL through a memory mapping
+        bool mapped = false;
+//      how corners are welded; the thread count is that of each conversion
+        WeldOptions weld;
+//      significant digits of vertex coordinates, 0 for the shortest exact
+        int precision = 0;
+//      convert out of core within this many bytes per file; 0 converts in
+//      memory
+        size_t memoryBudget = 0;
+//      read, weld and write each file concurrently (PipelineConvert)
+        bool pipelined = false;
+//      directory of a ConvertCache shared by all jobs; empty for none
+        std::string cacheDir;
+        uint64_t cacheSize = uint64_t(1) << 30;
+//      passes over the welded mesh (in-memory conversions only)
+        MeshPasses passes;
+    };
+
+    struct Result {
+        BatchJob job;
+        bool ok = false;
+        bool cached = false;    // the output came from the cache
+        std::string error;
+        double seconds = 0.0;
+    };
+
+    explicit BatchConvert(const Options& options);
+
+//  Convert all jobs and return their results in job order. Progress lines
+//  go to stdout and failures to stderr as the jobs finish; the progress
+//  messages of the individual conversions are suppressed.
+    std::vector<Result> run(const std::vector<BatchJob>& jobs);
+
+private:
+    Options options_;
+
+    bool convert(const BatchJob& job) const;
+    size_t estimateMemory(const BatchJob& job) const;
+};
+
+// Jobs from a manifest file with one "input output" pair per line. The two
+// names are separated by a tab if the line has one, and by white space
+// otherwise. Without an output name, the input name (without ".gz") with
+// the extension ".obj" is used. Blank lines and lines starting with '#' are
+// skipped.
+std::vector<BatchJob> readManifest(const std::string& filename);
+
+// Jobs for every .stl or .stl.gz file (in any letter case) in "directory",
+// sorted by name, each written to "outputDir" (or "directory" if empty)
+// under the same name with the extension ".obj".
+std::vector<BatchJob> listDirectory(const std::string& directory,
+    const std::string& outputDir);
+
+#endif // TYPE_BATCHCONVERT_H_
@@ -0,0 +1,110 @@
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TYPE_CHUNKWRITER_H_
+#define TYPE_CHUNKWRITER_H_
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include "outputsink.h"
+#include "textbuffer.h"
+#include "parallel.h"
+
+//  Writes text that is made of many independently formatted items (lines)
+//  using several threads. Items are processed in rounds: each thread formats
+//  a contiguous chunk of items into its own buffer, the chunk offsets follow
+//  from the buffer sizes, and then every thread writes its buffer at its
+//  offset with a positional write. Since the text of an item doesn't depend
+//  on how items are grouped, the file is byte-identical for any number of
+//  threads, and the memory held in buffers is bounded by the round size.
+//  Sinks without positional writes get the buffers in order from the
+//  calling thread instead; formatting is still parallel.
+class ChunkWriter {
+    OutputSink& file_;
+    unsigned threads_;
+    uint64_t offset_ = 0;
+    std::vector<TextBuffer> buffers_;
+//  wall time spent formatting and writing items
+    std::chrono::steady_clock::duration formatTime_{};
+    std::chrono::steady_clock::duration writeTime_{};
+
+public:
+//  items formatted per thread and round
+    static const size_t CHUNK_ITEMS = 1 << 16;
+
+    ChunkWriter(OutputSink& file, unsigned threads) :
+        file_(file), threads_(resolveThreads(threads)), buffers_(threads_) {}
+
+//  write text that was formatted by the caller
+    void append(const TextBuffer& text) {
+        put(text, offset_);
+        offset_ += text.size();
+    }
+
+//  write items 0 to n - 1, formatted by format(TextBuffer&, size_t item)
+    template <typename Format>
+    void appendItems(size_t n, Format format);
+
+//  number of bytes written so far
+    uint64_t offset() const { return offset_; }
+
+//  seconds spent in the formatting and the writing phases of appendItems
+    double formatSeconds() const {
+        return std::chrono::duration<double>(formatTime_).count();
+    }
+    double writeSeconds() const {
+        return std::chrono::duration<double>(writeTime_).count();
+    }
+
+private:
+    void put(const TextBuffer& text, uint64_t offset) {
+        if (file_.writesAt()) {
+            file_.writeAt(text.data(), text.size(), offset);
+        } else {
+            file_.write(text.data(), text.size());
+        }
+    }
+};
+
+template <typename Format>
+void ChunkWriter::appendItems(size_t n, Format format)
+{
+    std::vector<uint64_t> at(threads_);
+    for (size_t first = 0; first < n; first += threads_ * CHUNK_ITEMS) {
+        size_t count = std::min<size_t>(n - first, threads_ * CHUNK_ITEMS);
+        unsigned chunks = chunkCount(count, threads_, CHUNK_ITEMS);
+
+        auto t0 = std::chrono::steady_clock::now();
+        parallelChunks(count, chunks, [&](unsigned c, size_t b, size_t e) {
+            buffers_[c].clear();
+            for (size_t i = b; i < e; i++) format(buffers_[c], first + i);
+        });
+        for (unsigned c = 0; c < chunks; c++) {
+            at[c] = offset_;
+            offset_ += buffers_[c].size();
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        unsigned writers = file_.writesAt() ? chunks : 1;
+        parallelChunks(chunks, writers, [&](unsigned, size_t b, size_t e) {
+            for (size_t c = b; c < e; c++) put(buffers_[c], at[c]);
+        });
+        formatTime_ += t1 - t0;
+        writeTime_ += std::chrono::steady_clock::now() - t1;
+    }
+}
+
+#endif // TYPE_CHUNKWRITER_H_
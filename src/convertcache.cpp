@@ -0,0 +1,205 @@
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "convertcache.h"
+#include "gzip.h"
+#include "hash64.h"
+#include "mappedfile.h"
+#include "outputfile.h"
+#include "exportply.h"
+#include "profiler.h"
+
+namespace fs = std::filesystem;
+
+// bump when the output of a conversion changes for the same options
+static const char* CACHE_VERSION = "stl2obj-cache-1";
+
+// the first two lines of every OBJ file we write
+static const char OBJ_HEAD[] = "# Object name\no ";
+
+// temporary files of crashed processes are removed after this long
+static const std::chrono::hours STALE_TEMP(1);
+
+ConvertCache::ConvertCache(const std::string& directory, uint64_t maxBytes) :
+    directory_(directory), maxBytes_(maxBytes)
+{
+    std::error_code error;
+    fs::create_directories(directory_, error);
+    if (!fs::is_directory(directory_)) {
+        throw std::runtime_error("cannot create cache directory \"" +
+            directory_ + "\"");
+    }
+}
+
+uint64_t ConvertCache::key(const std::string& input, const std::string& tag,
+    const std::string& output) const
+{
+    ProfileStage stage("hash");
+    std::string options = std::string(CACHE_VERSION) + "\n" + tag + "\n" +
+        (isPLYFile(output) ? "ply" : "obj");
+//  the object name inside a compressed file can't be replaced on a hit, so
+//  it becomes part of the key
+    if (isGzipFile(output)) options += "\ngzip " + output;
+    MappedFile file(input);
+    Profiler::bytesRead(file.size());
+    return hash64(file.data(), file.size(),
+        hash64(options.data(), options.size()));
+}
+
+std::string ConvertCache::entryPath(uint64_t key,
+    const std::string& output) const
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.%s", (unsigned long long)key,
+        isPLYFile(output) ? "ply" : "obj");
+    return directory_ + "/" + name;
+}
+
+bool ConvertCache::fetch(uint64_t key, const std::string& output) const
+{
+    std::string entry = entryPath(key, output);
+//  an entry that can't be opened, e.g. because it was just evicted, is
+//  simply a miss
+    std::unique_ptr<MappedFile> file;
+    try {
+        file.reset(new MappedFile(entry));
+    } catch (const std::runtime_error&) {
+        Profiler::count("cache.misses");
+        return false;
+    }
+
+    const char* data = file->data();
+    const char* end = data + file->size();
+    OutputFile out(output);
+    const size_t HEAD = sizeof(OBJ_HEAD) - 1;
+    if (!isPLYFile(output) && file->size() > HEAD &&
+        std::memcmp(data, OBJ_HEAD, HEAD) == 0) {
+        const char* eol = (const char*)std::memchr(data + HEAD, '\n',
+            end - data - HEAD);
+        if (eol) {
+            std::string head = OBJ_HEAD + output;
+            out.write(head.data(), head.size());
+            data = eol;
+        }
+    }
+    out.write(data, end - data);
+
+    std::error_code error;
+    fs::last_write_time(entry, fs::file_time_type::clock::now(), error);
+    Profiler::count("cache.hits");
+    return true;
+}
+
+void ConvertCache::store(uint64_t key, const std::string& output) const
+{
+    static std::atomic<unsigned> counter(0);
+    char suffix[64];
+    snprintf(suffix, sizeof(suffix), "/.tmp-%ld-%zx-%u", (long)getpid(),
+        std::hash<std::thread::id>()(std::this_thread::get_id()), counter++);
+    std::string temp = directory_ + suffix;
+
+//  the cache is an optimization; failing to fill it isn't an error
+    try {
+        {
+            MappedFile src(output);
+            OutputFile dst(temp);
+            dst.write(src.data(), src.size());
+        }
+        if (std::rename(temp.c_str(), entryPath(key, output).c_str()) != 0) {
+            throw std::runtime_error(std::string("cannot rename \"") + temp +
+                "\": " + std::strerror(errno));
+        }
+        evict();
+    } catch (const std::exception& e) {
+        ::unlink(temp.c_str());
+        std::cerr << "warning: conversion not cached: " << e.what() <<
+            std::endl;
+    }
+}
+
+//  Only names of the form <16 hex digits>.obj/.ply are entries; anything
+//  else in the directory is left alone, except our own stale temporaries.
+void ConvertCache::evict() const
+{
+    struct Entry {
+        fs::path path;
+        fs::file_time_type time;
+        uint64_t size;
+    };
+    std::vector<Entry> entries;
+    uint64_t total = 0;
+    std::error_code error;
+    const auto now = fs::file_time_type::clock::now();
+    for (const auto& item : fs::directory_iterator(directory_, error)) {
+        std::string name = item.path().filename().string();
+        Entry entry { item.path(), item.last_write_time(error), 0 };
+        if (error) continue;
+        if (name.compare(0, 5, ".tmp-") == 0) {
+            if (now - entry.time > STALE_TEMP) fs::remove(item.path(), error);
+            continue;
+        }
+        if (name.size() != 20 ||
+            name.find_first_not_of("0123456789abcdef") != 16 ||
+            (name.compare(16, 4, ".obj") != 0 &&
+            name.compare(16, 4, ".ply") != 0)) {
+            continue;
+        }
+        entry.size = item.file_size(error);
+        if (error) continue;
+        total += entry.size;
+        entries.push_back(entry);
+    }
+    if (total <= maxBytes_) return;
+
+    std::sort(entries.begin(), entries.end(),
+        [](const Entry& a, const Entry& b) { return a.time < b.time; });
+    for (const Entry& entry : entries) {
+        if (total <= maxBytes_) break;
+//      another process may have removed it already
+        fs::remove(entry.path, error);
+        total -= entry.size;
+        Profiler::count("cache.evictions");
+    }
+}
+
+std::string cacheTag(const WeldOptions& weld, int precision, bool streaming,
+    const MeshPasses& passes)
+{
+    char tag[256];
+    snprintf(tag, sizeof(tag), "method=%d tolerance=%.17g precision=%d "
+        "real=%s layout=%s streaming=%d passes=%s", (int)weld.method,
+        weld.tolerance, precision,
+        sizeof(Geometry::Real) == sizeof(float) ? "float" : "double",
+#ifdef STL2OBJ_SOA
+        "soa",
+#else
+        "aos",
+#endif
+        (int)streaming, passes.describe().c_str());
+    return tag;
+}
@@ -0,0 +1,78 @@
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TYPE_CONVERTCACHE_H_
+#define TYPE_CONVERTCACHE_H_
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "weld.h"
+#include "meshpasses.h"
+
+// On-disk cache of converted files, keyed by a hash of the input content
+// and of every option that changes the output. A hit costs one read of the
+// input (to hash it) plus a copy of the stored output.
+//
+// Several processes may share a cache directory. Entries are written to a
+// private temporary file and renamed into place, so a reader sees either a
+// complete entry or none. A hit refreshes the modification time of the
+// entry, and after every store the least recently used entries are removed
+// until the cache fits in its size limit. An entry removed while someone
+// is reading it stays readable until they are done.
+class ConvertCache {
+public:
+    ConvertCache(const std::string& directory, uint64_t maxBytes);
+
+//  Key of converting "input" with the options described by "tag" into a
+//  file of the type of "output" (by its extension).
+    uint64_t key(const std::string& input, const std::string& tag,
+        const std::string& output) const;
+
+//  Copy the entry for "key" to "output" and return true, or return false if
+//  there is no such entry. The object name of an OBJ entry is replaced by
+//  "output", so the file is identical to a fresh conversion.
+    bool fetch(uint64_t key, const std::string& output) const;
+
+//  add "output", which has just been converted, as the entry for "key"
+    void store(uint64_t key, const std::string& output) const;
+
+//  Convert through the cache: fetch, or else run convert() and store.
+//  Returns true on a hit.
+    template <typename Convert>
+    bool convert(const std::string& input, const std::string& tag,
+        const std::string& output, Convert convert) const
+    {
+        uint64_t k = key(input, tag, output);
+        if (fetch(k, output)) return true;
+        convert();
+        store(k, output);
+        return false;
+    }
+
+private:
+    std::string directory_;
+    uint64_t maxBytes_;
+
+    std::string entryPath(uint64_t key, const std::string& output) const;
+    void evict() const;
+};
+
+// Description of the options that affect the converted file, for use as
+// the "tag" of a cache key.
+std::string cacheTag(const WeldOptions& weld, int precision, bool streaming,
+    const MeshPasses& passes);
+
+#endif // TYPE_CONVERTCACHE_H_
@@ -0,0 +1,258 @@
+// stl2obj converts an STL CAD file to OBJ format.
+
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TYPE_DYNAMICKDTREE_H_
+#define TYPE_DYNAMICKDTREE_H_
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+#include <algorithm>
+#include "vectornd.h"
+#include "simdkernels.h"
+
+// A point index for interleaved insertions and nearest-point queries that
+// stays balanced whatever the insertion order. An insertion-built K-D tree
+// degenerates into a list when points arrive sorted, which is common in STL
+// files; here the points live in a logarithmic forest instead (Bentley and
+// Saxe): new points collect in a small buffer that is searched linearly,
+// and a full buffer is merged with the trees of all lower levels into one
+// balanced tree, so level i holds either nothing or BUFFER << i points.
+// Every point is rebuilt O(log n) times, and a query searches O(log n)
+// trees of logarithmic depth, whatever the order of the points.
+//
+// The trees are implicit: each is an array of point ids whose middle
+// element splits the range along the axis of its depth, so they need no
+// child links. Each tree keeps a copy of its points in tree order, which is
+// the order the search touches them in.
+template <int DIM, typename Real = double>
+class DynamicKDTree {
+    using Point = VectorND<DIM, Real>;
+
+//  points searched linearly, before they go into a tree
+    static const unsigned BUFFER = 32;
+//  ranges this short are leaves, also searched linearly
+    static const unsigned LEAF = 8;
+
+    struct Tree {
+        std::vector<uint32_t> ids_;
+        std::vector<Point> points_;
+    };
+
+//  all points by id, in order of insertion
+    std::vector<Point> data_;
+    std::vector<uint32_t> buffer_;
+//  coordinates of the buffered points by axis, for distSqrBatch
+    Real bufferAxes_[DIM][BUFFER];
+    std::vector<Tree> trees_;
+
+//  the batch distance kernels exist for 3D float and double points
+    static constexpr bool BATCH = DIM == 3 &&
+        (std::is_same<Real, float>::value || std::is_same<Real, double>::value);
+
+public:
+//  same counters as KDTree::Stats; tree nodes and leaf points are visits
+    struct Stats {
+        uint64_t queries = 0;
+        uint64_t nodesVisited = 0;
+        uint64_t maxNodesVisited = 0;
+        uint64_t inserts = 0;
+        uint64_t maxDepth = 0;
+        uint64_t rebuilds = 0;
+        uint64_t rebuiltPoints = 0;
+    };
+
+private:
+    Stats stats_;
+
+public:
+    DynamicKDTree() = default;
+
+    DynamicKDTree(const DynamicKDTree&) = delete;
+    DynamicKDTree& operator=(const DynamicKDTree&) = delete;
+
+    void insert(const Point& point);
+
+    size_t size() const { return data_.size(); }
+
+//  Index of the nearest point, or -1 if there are none. Ties are resolved
+//  in favour of the lower index.
+    int findNearest(const Point& point);
+
+    Point getPoint(int index) const { return data_[index]; }
+
+//  number of non-empty trees, besides the buffer
+    size_t numOfTrees() const {
+        size_t count = 0;
+        for (const Tree& tree : trees_) count += !tree.ids_.empty();
+        return count;
+    }
+
+    const Stats& stats() const { return stats_; }
+
+private:
+    void build(Tree& tree);
+    void build(uint32_t* begin, uint32_t* end, int axis);
+    void search(const Tree& tree, const Point& point, int& best,
+        Real& bestDist, uint64_t& visited) const;
+};
+
+template <int DIM, typename Real>
+void DynamicKDTree<DIM, Real>::insert(const Point& point)
+{
+    uint32_t id = data_.size();
+    data_.push_back(point);
+    for (int a = 0; a < DIM; a++) bufferAxes_[a][buffer_.size()] = point[a];
+    buffer_.push_back(id);
+    stats_.inserts++;
+    if (buffer_.size() < BUFFER) return;
+
+//  carry the buffer up like a binary counter: it and the full trees below
+//  the first empty level become the tree of that level
+    size_t level = 0;
+    std::vector<uint32_t> ids;
+    ids.swap(buffer_);
+    while (level < trees_.size() && !trees_[level].ids_.empty()) {
+        Tree& tree = trees_[level];
+        ids.insert(ids.end(), tree.ids_.begin(), tree.ids_.end());
+        tree.ids_ = std::vector<uint32_t>();
+        tree.points_ = std::vector<Point>();
+        level++;
+    }
+    if (level == trees_.size()) trees_.emplace_back();
+    trees_[level].ids_.swap(ids);
+    build(trees_[level]);
+    buffer_.reserve(BUFFER);
+}
+
+template <int DIM, typename Real>
+void DynamicKDTree<DIM, Real>::build(Tree& tree)
+{
+    std::vector<uint32_t>& ids = tree.ids_;
+    build(ids.data(), ids.data() + ids.size(), 0);
+    tree.points_.resize(ids.size());
+    for (size_t i = 0; i < ids.size(); i++) tree.points_[i] = data_[ids[i]];
+    stats_.rebuilds++;
+    stats_.rebuiltPoints += ids.size();
+    uint64_t depth = 1;
+    for (size_t n = ids.size(); n > LEAF; n /= 2) depth++;
+    stats_.maxDepth = std::max(stats_.maxDepth, depth);
+}
+
+//  the median along "axis" goes to the middle of [begin, end); no point
+//  before it is larger and no point after it smaller
+template <int DIM, typename Real>
+void DynamicKDTree<DIM, Real>::build(uint32_t* begin, uint32_t* end, int axis)
+{
+    if (end - begin <= (ptrdiff_t)LEAF) return;
+    uint32_t* median = begin + (end - begin) / 2;
+    std::nth_element(begin, median, end, [this, axis](uint32_t a, uint32_t b) {
+        return data_[a][axis] < data_[b][axis];
+    });
+    int next = (axis + 1) % DIM;
+    build(begin, median, next);
+    build(median + 1, end, next);
+}
+
+template <int DIM, typename Real>
+int DynamicKDTree<DIM, Real>::findNearest(const Point& point)
+{
+    int best = -1;
+    Real bestDist = std::numeric_limits<Real>::max();
+    uint64_t visited = 0;
+//  recent points first; in STL files they are usually the nearest
+    Real dist[BUFFER];
+    if constexpr (BATCH) {
+        const Real p[3] = {point[0], point[1], point[2]};
+        distSqrBatch(bufferAxes_[0], bufferAxes_[1], bufferAxes_[2],
+            buffer_.size(), p, dist);
+    } else {
+        for (size_t k = 0; k < buffer_.size(); k++) {
+            dist[k] = Point::get_dist_sqr(point, data_[buffer_[k]]);
+        }
+    }
+//  ids ascend in the buffer, so the first of equal distances has the
+//  lowest one
+    for (size_t k = 0; k < buffer_.size(); k++) {
+        if (dist[k] < bestDist) {
+            bestDist = dist[k];
+            best = buffer_[k];
+        }
+    }
+    visited += buffer_.size();
+    for (const Tree& tree : trees_) {
+        if (!tree.ids_.empty()) search(tree, point, best, bestDist, visited);
+    }
+    stats_.queries++;
+    stats_.nodesVisited += visited;
+    stats_.maxNodesVisited = std::max(stats_.maxNodesVisited, visited);
+    return best;
+}
+
+//  Iterative search with a stack of (range, axis, squared distance to the
+//  range's side of the parent's split). Ranges strictly farther than the
+//  best distance are skipped, so a tie with a lower id is never missed.
+template <int DIM, typename Real>
+void DynamicKDTree<DIM, Real>::search(const Tree& tree, const Point& point,
+    int& best, Real& bestDist, uint64_t& visited) const
+{
+    struct Range {
+        uint32_t begin, end;
+        int axis;
+        Real bound;
+    };
+    Range stack[2 * 64];
+    int top = 0;
+    stack[top++] = Range{0, (uint32_t)tree.ids_.size(), 0, Real(0)};
+    auto offer = [&](uint32_t k) {
+        Real d = Point::get_dist_sqr(point, tree.points_[k]);
+        int id = tree.ids_[k];
+        if (d < bestDist || (d == bestDist && id < best)) {
+            bestDist = d;
+            best = id;
+        }
+    };
+    while (top > 0) {
+        Range range = stack[--top];
+        if (range.bound > bestDist) continue;
+        if (range.end - range.begin <= LEAF) {
+            for (uint32_t k = range.begin; k < range.end; k++) offer(k);
+            visited += range.end - range.begin;
+            continue;
+        }
+        uint32_t mid = range.begin + (range.end - range.begin) / 2;
+        visited++;
+        offer(mid);
+        Real diff = point[range.axis] - tree.points_[mid][range.axis];
+        int next = (range.axis + 1) % DIM;
+        Range lower{range.begin, mid, next, range.bound};
+        Range upper{mid + 1, range.end, next, range.bound};
+        if (diff <= 0) {
+            upper.bound = diff * diff;
+            stack[top++] = upper;
+            stack[top++] = lower;
+        } else {
+            lower.bound = diff * diff;
+            stack[top++] = lower;
+            stack[top++] = upper;
+        }
+    }
+}
+
+#endif // TYPE_DYNAMICKDTREE_H_
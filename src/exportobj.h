@@ -21,15 +21,34 @@
 #include <string>
 #include "visitor.h"
 #include "geometry.h"
+#include "outputsink.h"
 
 class ExportOBJ : public Visitor<Geometry> {
     std::string filename_;
+//  where the file goes, or nullptr to create "filename_"
+    OutputSink* sink_ = nullptr;
+//  significant digits of vertex coordinates; 0 means the shortest string
+//  that reads back as the same value
+    int precision_;
+//  number of threads formatting and writing the file; 0 uses all cores
+    unsigned threads_;
 public:
-    ExportOBJ(const std::string& filename) :
-        filename_(filename) {}
+    ExportOBJ(const std::string& filename, int precision = 0,
+        unsigned threads = 1) :
+        filename_(filename), precision_(precision), threads_(threads) {}
+
+//  Write to "sink", with "name" as the object name in the file. This is a
+//  library call, so it prints no progress messages.
+    ExportOBJ(OutputSink& sink, const std::string& name, int precision = 0,
+        unsigned threads = 1) :
+        filename_(name), sink_(&sink), precision_(precision),
+        threads_(threads) {}
 
     void dispatch(Geometry& model) override {
-        std::cout << "Saving OBJ file: \"" << filename_ << "\"" << std::endl;
+        if (!sink_) {
+            std::cout << "Saving OBJ file: \"" << filename_ << "\"" <<
+                std::endl;
+        }
         save(model);
     }
 
@@ -0,0 +1,131 @@
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include "exportply.h"
+#include "outputfile.h"
+#include "gzip.h"
+#include "profiler.h"
+
+static const bool LITTLE_ENDIAN_HOST =
+    (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__);
+
+// items per block of the buffered paths
+static const size_t BLOCK_ITEMS = 1 << 16;
+
+// store "value" at "out" in little-endian byte order and advance "out"
+template <typename T>
+static void putLE(char*& out, T value)
+{
+    std::memcpy(out, &value, sizeof(T));
+    if (!LITTLE_ENDIAN_HOST) std::reverse(out, out + sizeof(T));
+    out += sizeof(T);
+}
+
+// Any vertex store: interleave the coordinates block by block.
+template <typename Store>
+static void writeVertices(OutputSink& file, const Store& verts)
+{
+    using Real = Geometry::Real;
+    std::vector<char> block(BLOCK_ITEMS * 3 * sizeof(Real));
+    for (size_t first = 0; first < verts.size(); first += BLOCK_ITEMS) {
+        size_t last = std::min(verts.size(), first + BLOCK_ITEMS);
+        char* out = block.data();
+        for (size_t i = first; i < last; i++) {
+            for (unsigned a = 0; a < 3; a++) putLE(out, verts.coord(i, a));
+        }
+        file.write(block.data(), out - block.data());
+    }
+}
+
+// Array of structures: the store already holds x, y, z triples back to back,
+// which is exactly the PLY vertex record.
+template <typename REAL>
+static void writeVertices(OutputSink& file,
+    const AosVertexStore<REAL>& verts)
+{
+    static_assert(sizeof(typename AosVertexStore<REAL>::Point) ==
+        3 * sizeof(REAL), "VectorND<3> must not be padded");
+    if (!LITTLE_ENDIAN_HOST) {
+        writeVertices<AosVertexStore<REAL>>(file, verts);
+        return;
+    }
+    file.write((const char*)verts.data(),
+        verts.size() * 3 * sizeof(REAL));
+}
+
+void ExportPLY::save(Geometry& model)
+{
+    ProfileStage stage("export");
+
+    OutputFile file (filename_);
+    std::unique_ptr<GzipSink> compressed;
+    if (isGzipFile(filename_)) compressed.reset(new GzipSink(file, threads_));
+    OutputSink& filePLY = compressed ? *compressed : (OutputSink&)file;
+    const size_t numOfFaces = model.faces_.size() / 3;
+    std::string header =
+        "ply\n"
+        "format binary_little_endian 1.0\n"
+        "comment generated by stl2obj\n"
+        "element vertex " + std::to_string(model.verts_.size()) + "\n";
+    const char* type = (sizeof(Geometry::Real) == sizeof(float)) ? "float"
+        : "double";
+    for (const char* axis : {"x", "y", "z"}) {
+        header += std::string("property ") + type + " " + axis + "\n";
+    }
+    header +=
+        "element face " + std::to_string(numOfFaces) + "\n"
+        "property list uchar uint vertex_indices\n"
+        "end_header\n";
+    filePLY.write(header.data(), header.size());
+
+    writeVertices(filePLY, model.verts_);
+
+//  faces need a count byte in front of every index triple
+    const size_t RECORD = 1 + 3 * sizeof(uint32_t);
+    std::vector<char> block(BLOCK_ITEMS * RECORD);
+    const unsigned* faces = model.faces_.data();
+    for (size_t first = 0; first < numOfFaces; first += BLOCK_ITEMS) {
+        size_t last = std::min(numOfFaces, first + BLOCK_ITEMS);
+        char* out = block.data();
+        for (size_t i = first; i < last; i++) {
+            *out++ = 3;
+            for (unsigned j = 0; j < 3; j++) {
+                putLE(out, (uint32_t)faces[3 * i + j]);
+            }
+        }
+        filePLY.write(block.data(), out - block.data());
+    }
+    filePLY.flush();
+
+    Profiler::bytesWritten(header.size() +
+        model.verts_.size() * 3 * sizeof(Geometry::Real) + numOfFaces * RECORD);
+    std::cout << "Finished writing PLY in " << stage.stop() <<
+        " seconds!" << std::endl;
+}
+
+bool isPLYFile(const std::string& name)
+{
+    std::string filename = stripGzipSuffix(name);
+    if (filename.size() < 4) return false;
+    std::string ext = filename.substr(filename.size() - 4);
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    return ext == ".ply";
+}
@@ -0,0 +1,49 @@
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TYPE_EXPORTPLY_H_
+#define TYPE_EXPORTPLY_H_
+#pragma once
+
+#include <iostream>
+#include <string>
+#include "visitor.h"
+#include "geometry.h"
+
+// Writes binary little-endian PLY: a short text header, then the vertex
+// coordinates in the precision of Geometry::Real, then every face as a
+// count byte followed by three 32-bit indices. Nothing is formatted as
+// text; on a little-endian machine with array-of-structures vertex storage
+// the vertices go to disk in a single write straight from the model.
+class ExportPLY : public Visitor<Geometry> {
+    std::string filename_;
+//  threads compressing the file if its name ends in .gz; 0 uses all cores
+    unsigned threads_;
+public:
+    explicit ExportPLY(const std::string& filename, unsigned threads = 1) :
+        filename_(filename), threads_(threads) {}
+
+    void dispatch(Geometry& model) override {
+        std::cout << "Saving PLY file: \"" << filename_ << "\"" << std::endl;
+        save(model);
+    }
+
+    void save(Geometry& model);
+};
+
+// true if "filename" ends in ".ply" or ".ply.gz" (in any letter case)
+bool isPLYFile(const std::string& filename);
+
+#endif // TYPE_EXPORTPLY_H_
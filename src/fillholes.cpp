@@ -0,0 +1,147 @@
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cmath>
+#include <cstdint>
+#include <queue>
+#include <set>
+#include <tuple>
+#include <utility>
+#include "fillholes.h"
+#include "meshadjacency.h"
+#include "parallel.h"
+#include "profiler.h"
+
+using Vec = VectorND<3, double>;
+
+static const double PI = 3.14159265358979323846;
+
+static Vec cross(const Vec& a, const Vec& b)
+{
+    return Vec(a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2],
+        a[0] * b[1] - a[1] * b[0]);
+}
+
+void triangulateLoop(const Geometry::VertexStore& verts,
+    const std::vector<unsigned>& loop, std::vector<unsigned>& faces,
+    const MeshAdjacency* adjacency)
+{
+    const size_t n = loop.size();
+    if (n < 3) return;
+    if (n == 3) {
+        faces.insert(faces.end(), loop.begin(), loop.end());
+        return;
+    }
+
+    std::vector<Vec> p(n);
+    for (size_t i = 0; i < n; i++) {
+        auto v = verts[loop[i]];
+        p[i] = Vec(v[0], v[1], v[2]);
+    }
+//  mean normal of the polygon (Newell's method)
+    Vec normal(0.0, 0.0, 0.0);
+    for (size_t i = 0; i < n; i++) {
+        normal = normal + cross(p[i], p[(i + 1) % n]);
+    }
+
+    std::vector<size_t> prev(n), next(n);
+    std::vector<unsigned> version(n, 0);
+    for (size_t i = 0; i < n; i++) {
+        prev[i] = (i + n - 1) % n;
+        next[i] = (i + 1) % n;
+    }
+//  edges added so far, as (smaller, larger) vertex pairs
+    std::set<std::pair<unsigned, unsigned>> added;
+    auto exists = [&](unsigned u, unsigned v) {
+        if (added.count(std::minmax(u, v))) return true;
+        return adjacency && adjacency->hasEdge(u, v);
+    };
+//  interior angle at corner i, in [0, 2 pi); ears that would duplicate an
+//  edge get a penalty that puts them behind all others
+    auto angle = [&](size_t i) {
+        Vec a = p[prev[i]] - p[i];
+        Vec b = p[next[i]] - p[i];
+        double theta = std::atan2(cross(b, a) * normal, a * b);
+        if (theta < 0.0) theta += 2.0 * PI;
+        if (exists(loop[prev[i]], loop[next[i]])) theta += 4.0 * PI;
+        return theta;
+    };
+
+//  ears ordered by angle, then by position for a deterministic order;
+//  entries of corners whose neighbours changed are stale
+    using Ear = std::tuple<double, size_t, unsigned>;
+    std::priority_queue<Ear, std::vector<Ear>, std::greater<Ear>> ears;
+    for (size_t i = 0; i < n; i++) ears.emplace(angle(i), i, 0);
+
+    for (size_t left = n; left > 3; ) {
+        Ear ear = ears.top();
+        ears.pop();
+        size_t i = std::get<1>(ear);
+        if (std::get<2>(ear) != version[i]) continue;
+        faces.push_back(loop[prev[i]]);
+        faces.push_back(loop[i]);
+        faces.push_back(loop[next[i]]);
+        added.insert(std::minmax(loop[prev[i]], loop[next[i]]));
+        next[prev[i]] = next[i];
+        prev[next[i]] = prev[i];
+        version[i] = UINT32_MAX;
+        left--;
+        for (size_t j : {prev[i], next[i]}) {
+            ears.emplace(angle(j), j, ++version[j]);
+        }
+    }
+//  the last triangle
+    while (version[std::get<1>(ears.top())] == UINT32_MAX) ears.pop();
+    size_t i = std::get<1>(ears.top());
+    faces.push_back(loop[prev[i]]);
+    faces.push_back(loop[i]);
+    faces.push_back(loop[next[i]]);
+}
+
+void FillHoles::fill(Geometry& model)
+{
+    ProfileStage stage("fill_holes");
+    MeshAdjacency adjacency(model.faces_, model.verts_.size(), threads_);
+//  The boundary half-edges of a hole run against the orientation the
+//  triangles closing it need, so each loop is reversed into a list of
+//  vertices.
+    std::vector<std::vector<unsigned>> loops;
+    for (const auto& edges : adjacency.boundaryLoops()) {
+        std::vector<unsigned> corners(edges.size());
+        for (size_t k = 0; k < edges.size(); k++) {
+            corners[edges.size() - 1 - k] = adjacency.target(edges[k]);
+        }
+        loops.push_back(std::move(corners));
+    }
+
+//  loops are independent; their triangles are appended in loop order
+    unsigned chunks = chunkCount(loops.size(), threads_, 1);
+    std::vector<std::vector<unsigned>> added(chunks);
+    parallelChunks(loops.size(), chunks, [&](unsigned c, size_t b, size_t e) {
+        for (size_t l = b; l < e; l++) {
+            triangulateLoop(model.verts_, loops[l], added[c], &adjacency);
+        }
+    });
+
+    size_t numOfTris = 0;
+    for (const auto& faces : added) {
+        model.faces_.insert(model.faces_.end(), faces.begin(), faces.end());
+        numOfTris += faces.size() / 3;
+    }
+    Profiler::count("fill.holes", loops.size());
+    Profiler::count("fill.triangles", numOfTris);
+    std::cout << "Filled " << loops.size() << " holes with " << numOfTris <<
+        " triangles in " << stage.stop() << " seconds!" << std::endl;
+}
@@ -0,0 +1,55 @@
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TYPE_FILLHOLES_H_
+#define TYPE_FILLHOLES_H_
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include "visitor.h"
+#include "geometry.h"
+#include "meshadjacency.h"
+
+// Closes the holes of a welded mesh: every closed loop of boundary edges is
+// triangulated with the existing vertices, and the new triangles are
+// appended to the mesh, oriented like their neighbours. Loops are found on
+// a MeshAdjacency table and triangulated concurrently; the result doesn't
+// depend on the number of threads.
+class FillHoles : public Visitor<Geometry> {
+    unsigned threads_;
+public:
+    explicit FillHoles(unsigned threads = 0) : threads_(threads) {}
+
+    void dispatch(Geometry& model) override {
+        std::cout << "Filling holes ..." << std::endl;
+        fill(model);
+    }
+
+    void fill(Geometry& model);
+};
+
+// Triangulate the polygon "loop" (vertex indices into "verts", in the order
+// the new triangles should follow) by clipping ears, smallest interior
+// angle first, and append the triangles to "faces". Angles are measured in
+// the plane of the polygon's mean normal, so reflex corners of non-convex
+// holes are clipped last. Ears whose new edge already exists, in the loop
+// or in "adjacency" if given, are clipped only when nothing else is left,
+// as they would make the mesh non-manifold.
+void triangulateLoop(const Geometry::VertexStore& verts,
+    const std::vector<unsigned>& loop, std::vector<unsigned>& faces,
+    const MeshAdjacency* adjacency = nullptr);
+
+#endif // TYPE_FILLHOLES_H_
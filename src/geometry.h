@@ -19,14 +19,31 @@
 
 #include <vector>
 #include "vectornd.h"
+#include "vertexstore.h"
 #include "geombase.h"
 #include "visitor.h"
 
+// Precision and layout of the vertex coordinates are chosen at build time.
+// STL files only store single-precision floats, so float is the default;
+// define STL2OBJ_REAL=double for double precision, and STL2OBJ_SOA to store
+// x, y and z in separate arrays.
+#ifndef STL2OBJ_REAL
+#define STL2OBJ_REAL float
+#endif
+
 // CRTP is used to avoid dynamic polymorphism
 class Geometry : public GeomBase<Geometry> {
 public:
-//  list of vertices as a vector of 3D points
-    std::vector<VectorND<>> verts_;
+    using Real = STL2OBJ_REAL;
+    using Point = VectorND<3, Real>;
+#ifdef STL2OBJ_SOA
+    using VertexStore = SoaVertexStore<Real>;
+#else
+    using VertexStore = AosVertexStore<Real>;
+#endif
+
+//  list of vertices as 3D points
+    VertexStore verts_;
 //  list of triangular faces as a vector of 3 indices. The indices point to
 //  the vertices in verts_.
     std::vector<unsigned> faces_;
@@ -0,0 +1,209 @@
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cstring>
+#include <stdexcept>
+#include <zlib.h>
+#include "gzip.h"
+#include "parallel.h"
+#include "profiler.h"
+
+// deflate's window: the most a block can refer back into earlier input
+static const size_t WINDOW_SIZE = 32 << 10;
+
+bool isGzip(const char* data, size_t size)
+{
+    return size >= 2 && (unsigned char)data[0] == 0x1f &&
+        (unsigned char)data[1] == 0x8b;
+}
+
+bool isGzipFile(const std::string& filename)
+{
+    if (filename.size() < 3) return false;
+    std::string ext = filename.substr(filename.size() - 3);
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    return ext == ".gz";
+}
+
+std::string stripGzipSuffix(const std::string& filename)
+{
+    return isGzipFile(filename) ?
+        filename.substr(0, filename.size() - 3) : filename;
+}
+
+void gunzip(const char* data, size_t size, std::vector<char>& out)
+{
+    out.clear();
+//  the trailer holds the size of the last member, modulo 4 GiB
+    if (size >= 4) {
+        uint32_t hint;
+        std::memcpy(&hint, data + size - 4, sizeof(hint));
+        out.reserve(hint);
+    }
+
+    z_stream stream;
+    std::memset(&stream, 0, sizeof(stream));
+//  15 + 16: full window, gzip header and trailer
+    if (inflateInit2(&stream, 15 + 16) != Z_OK) {
+        throw std::runtime_error("cannot initialize zlib");
+    }
+    const unsigned char* next = (const unsigned char*)data;
+    const unsigned char* end = next + size;
+    size_t used = 0;
+    int status = Z_OK;
+    while (true) {
+        if (out.size() - used < (1 << 16)) {
+            out.resize(std::max<size_t>(2 * out.size(), used + (1 << 20)));
+        }
+        stream.next_in = (unsigned char*)next;
+        stream.avail_in = (uInt)std::min<size_t>(end - next, UINT_MAX);
+        stream.next_out = (unsigned char*)out.data() + used;
+        stream.avail_out = (uInt)std::min<size_t>(out.size() - used,
+            UINT_MAX);
+        uInt room = stream.avail_out;
+        status = inflate(&stream, Z_NO_FLUSH);
+        next = stream.next_in;
+        used += room - stream.avail_out;
+        if (status == Z_STREAM_END) {
+//          another member may follow
+            if (next == end) break;
+            inflateReset(&stream);
+        } else if (status != Z_OK && status != Z_BUF_ERROR) {
+            inflateEnd(&stream);
+            throw std::runtime_error("corrupt gzip data");
+        } else if (next == end && stream.avail_out != 0) {
+            inflateEnd(&stream);
+            throw std::runtime_error("truncated gzip data");
+        }
+    }
+    inflateEnd(&stream);
+    out.resize(used);
+}
+
+GzipSink::GzipSink(OutputSink& out, unsigned threads, int level) :
+    out_(out), threads_(resolveThreads(threads)), level_(level),
+    crc_(crc32(0, Z_NULL, 0)) {}
+
+void GzipSink::write(const char* data, size_t size)
+{
+    pending_.insert(pending_.end(), data, data + size);
+    size_ += size;
+//  a round gives every thread a few blocks
+    if (pending_.size() >= 4 * threads_ * BLOCK_SIZE) compress(false);
+}
+
+void GzipSink::flush()
+{
+    if (finished_) return;
+    compress(true);
+    unsigned char trailer[8];
+    uint32_t length = (uint32_t)size_;
+    for (int i = 0; i < 4; i++) {
+        trailer[i] = (unsigned char)(crc_ >> (8 * i));
+        trailer[4 + i] = (unsigned char)(length >> (8 * i));
+    }
+    out_.write((const char*)trailer, sizeof(trailer));
+    compressedSize_ += sizeof(trailer);
+    out_.flush();
+    finished_ = true;
+    Profiler::count("gzip.input_bytes", size_);
+    Profiler::count("gzip.output_bytes", compressedSize_);
+}
+
+//  Compress the complete blocks of the pending input, or all of it if this
+//  is the last round. Blocks are deflated in parallel; their output is
+//  then written in order.
+void GzipSink::compress(bool last)
+{
+    if (!started_) {
+//      magic, deflate, no flags, no time stamp, no extra flags, Unix
+        static const unsigned char header[10] =
+            { 0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 3 };
+        out_.write((const char*)header, sizeof(header));
+        compressedSize_ += sizeof(header);
+        started_ = true;
+    }
+
+    size_t numOfBlocks = last ?
+        std::max<size_t>(1, (pending_.size() + BLOCK_SIZE - 1) / BLOCK_SIZE) :
+        pending_.size() / BLOCK_SIZE;
+    size_t consumed = std::min(pending_.size(), numOfBlocks * BLOCK_SIZE);
+    if (blocks_.size() < numOfBlocks) blocks_.resize(numOfBlocks);
+    std::vector<uint32_t> crcs(numOfBlocks);
+
+    unsigned chunks = chunkCount(numOfBlocks, threads_, 1);
+    parallelChunks(numOfBlocks, chunks, [&](unsigned, size_t b, size_t e) {
+        z_stream stream;
+        std::memset(&stream, 0, sizeof(stream));
+//      raw deflate: the gzip header and trailer are written above
+        if (deflateInit2(&stream, level_, Z_DEFLATED, -15, 8,
+            Z_DEFAULT_STRATEGY) != Z_OK) {
+            throw std::runtime_error("cannot initialize zlib");
+        }
+        for (size_t k = b; k < e; k++) {
+            const char* begin = pending_.data() + k * BLOCK_SIZE;
+            size_t size = std::min(BLOCK_SIZE, consumed - k * BLOCK_SIZE);
+            deflateReset(&stream);
+            if (k > 0) {
+                deflateSetDictionary(&stream,
+                    (const Bytef*)(begin - WINDOW_SIZE), WINDOW_SIZE);
+            } else if (!window_.empty()) {
+                deflateSetDictionary(&stream, (const Bytef*)window_.data(),
+                    window_.size());
+            }
+            std::vector<char>& block = blocks_[k];
+//          room for incompressible data plus the flush markers
+            block.resize(deflateBound(&stream, size) + 16);
+            stream.next_in = (Bytef*)begin;
+            stream.avail_in = (uInt)size;
+            stream.next_out = (Bytef*)block.data();
+            stream.avail_out = (uInt)block.size();
+            int flush = (last && k + 1 == numOfBlocks) ? Z_FINISH :
+                Z_SYNC_FLUSH;
+            int status = deflate(&stream, flush);
+            if (status == Z_STREAM_ERROR || stream.avail_in != 0 ||
+                (flush == Z_FINISH && status != Z_STREAM_END)) {
+                deflateEnd(&stream);
+                throw std::runtime_error("cannot compress output");
+            }
+            block.resize(block.size() - stream.avail_out);
+            crcs[k] = crc32(0, (const Bytef*)begin, (uInt)size);
+        }
+        deflateEnd(&stream);
+    });
+
+    for (size_t k = 0; k < numOfBlocks; k++) {
+        out_.write(blocks_[k].data(), blocks_[k].size());
+        compressedSize_ += blocks_[k].size();
+        size_t size = std::min(BLOCK_SIZE, consumed - k * BLOCK_SIZE);
+        crc_ = crc32_combine(crc_, crcs[k], (z_off_t)size);
+    }
+
+//  keep the window for the next round, and the incomplete block
+    if (consumed >= WINDOW_SIZE) {
+        window_.assign(pending_.begin() + (consumed - WINDOW_SIZE),
+            pending_.begin() + consumed);
+    } else {
+        window_.insert(window_.end(), pending_.begin(),
+            pending_.begin() + consumed);
+        if (window_.size() > WINDOW_SIZE) {
+            window_.erase(window_.begin(), window_.end() - WINDOW_SIZE);
+        }
+    }
+    pending_.erase(pending_.begin(), pending_.begin() + consumed);
+}
@@ -0,0 +1,89 @@
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TYPE_GZIP_H_
+#define TYPE_GZIP_H_
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "outputsink.h"
+
+// gzip support on top of zlib: recognizing compressed data, inflating a
+// buffer, and compressing output on several threads.
+
+// true if the buffer starts with the gzip magic number
+bool isGzip(const char* data, size_t size);
+
+// true if "filename" ends in ".gz" (in any letter case)
+bool isGzipFile(const std::string& filename);
+
+// "filename" without a trailing ".gz"
+std::string stripGzipSuffix(const std::string& filename);
+
+// Inflate the gzip data in [data, data + size) into "out", replacing its
+// contents but keeping its capacity. Concatenated gzip members are inflated
+// one after the other, like gunzip does. Throws std::runtime_error if the
+// data is corrupt or truncated.
+void gunzip(const char* data, size_t size, std::vector<char>& out);
+
+// Compresses everything written to it into a single gzip member, in the
+// manner of pigz: the input is cut into blocks of BLOCK_SIZE bytes, and
+// blocks are deflated independently on "threads" threads (0 means all
+// cores). Each block is primed with the last 32 KiB of the input before it
+// as its dictionary and ends on a byte boundary (a sync flush), so the
+// compressed blocks simply concatenate into one deflate stream, and their
+// CRCs are joined with crc32_combine. The compression ratio is within a
+// fraction of a percent of single-threaded gzip, and the output is the same
+// for any number of threads.
+//
+// flush() must be called after the last write; it compresses the rest and
+// writes the gzip trailer.
+class GzipSink : public OutputSink {
+public:
+//  input bytes per independently compressed block
+    static const size_t BLOCK_SIZE = 128 << 10;
+
+    GzipSink(OutputSink& out, unsigned threads, int level = 6);
+
+    void write(const char* data, size_t size) override;
+    void flush() override;
+
+//  bytes handed to the sink and bytes of gzip data written
+    uint64_t size() const { return size_; }
+    uint64_t compressedSize() const { return compressedSize_; }
+
+private:
+    OutputSink& out_;
+    unsigned threads_;
+    int level_;
+//  input that hasn't been compressed yet
+    std::vector<char> pending_;
+//  last 32 KiB of the input that has been compressed
+    std::vector<char> window_;
+//  output of every block of the current round
+    std::vector<std::vector<char>> blocks_;
+    uint32_t crc_;
+    uint64_t size_ = 0;
+    uint64_t compressedSize_ = 0;
+    bool started_ = false;
+    bool finished_ = false;
+
+    void compress(bool last);
+};
+
+#endif // TYPE_GZIP_H_
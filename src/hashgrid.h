@@ -0,0 +1,242 @@
+// stl2obj converts an STL CAD file to OBJ format.
+
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TYPE_HASHGRID_H_
+#define TYPE_HASHGRID_H_
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "vectornd.h"
+
+//  Uniform hash grid for merging points within a fixed radius. It offers the
+//  same insert/findNearest/getPoint interface as KDTree, but a lookup costs
+//  expected O(1) instead of a tree traversal:
+//  1) Points that are bitwise identical to a stored point are found with a
+//     single probe of a hash table keyed by the exact coordinate bits. Most
+//     STL exporters write shared corners this way.
+//  2) Otherwise, the cells of size "radius" that surround the point are
+//     probed. Any stored point within the radius must lie in one of them.
+template <int DIM, typename Real = double>
+class HashGrid {
+//  define Point type for convenience
+    using Point = VectorND<DIM, Real>;
+    using Cell = int64_t[DIM];
+
+//  open-addressing slot of the exact table; stores id + 1, 0 means empty
+    std::vector<uint32_t> exact_;
+//  open-addressing slot of the cell table: cell coordinates and the last
+//  point inserted into the cell
+    struct CellSlot {
+        int64_t key[DIM];
+        uint32_t head; // id + 1, 0 means empty
+    };
+    std::vector<CellSlot> cells_;
+    size_t numOfCells_ = 0;
+//  previous point in the same cell (id + 1, 0 terminates the chain)
+    std::vector<uint32_t> next_;
+
+//  all points, indexed by the order of insertion
+    std::vector<Point> data_;
+
+//  merge radius, which is also the edge length of a cell
+    Real radius_;
+//  squared radius in double, the acceptance test of the other welders
+    double radiusSqr_;
+
+public: // methods
+    explicit HashGrid(double radius) : exact_(1024, 0), cells_(1024),
+        radius_(radius), radiusSqr_(radius * radius) {}
+
+//  delete copy constructor and assignment operator, for the same reason as
+//  in KDTree
+    HashGrid(const HashGrid&) = delete;
+    HashGrid& operator=(const HashGrid&) = delete;
+
+//  insert a new point
+    void insert(const Point& point);
+
+//  get the current size
+    size_t size() const { return data_.size(); }
+
+//  Return the index of the stored point nearest to "point" if it is not
+//  farther than the radius, or -1 otherwise.
+    int findNearest(const Point& point) const;
+
+//  return the point from its id
+    Point getPoint(int index) const {
+        return data_[index];
+    }
+
+private: // methods
+    static uint64_t mix(uint64_t h) {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        return h ^ (h >> 33);
+    }
+    static uint64_t hashBits(const Point& point) {
+        uint64_t h = 0;
+        for (int a = 0; a < DIM; a++) {
+            uint64_t bits = 0;
+            std::memcpy(&bits, &point[a], sizeof(Real));
+            h = mix(h ^ bits);
+        }
+        return h;
+    }
+    static uint64_t hashCell(const Cell& cell) {
+        uint64_t h = 0;
+        for (int a = 0; a < DIM; a++) h = mix(h ^ (uint64_t)cell[a]);
+        return h;
+    }
+    static bool sameBits(const Point& p, const Point& q) {
+        return std::memcmp(&p[0], &q[0], DIM * sizeof(Real)) == 0;
+    }
+    static bool sameCell(const int64_t* a, const int64_t* b) {
+        for (int i = 0; i < DIM; i++) if (a[i] != b[i]) return false;
+        return true;
+    }
+    bool useCells() const { return radius_ > 0; }
+    void getCell(const Point& point, Cell& cell) const;
+    CellSlot* findCell(const Cell& cell);
+    const CellSlot* findCell(const Cell& cell) const {
+        return const_cast<HashGrid*>(this)->findCell(cell);
+    }
+    void grow();
+};
+
+template <int DIM, typename Real>
+void HashGrid<DIM, Real>::getCell(const Point& point, Cell& cell) const
+{
+//  clamp far-away points instead of overflowing; they merely share a cell
+    const Real LIMIT = Real(int64_t(1) << 62);
+    for (int a = 0; a < DIM; a++) {
+        Real c = std::floor(point[a] / radius_);
+        cell[a] = (int64_t)std::max(-LIMIT, std::min(LIMIT, c));
+    }
+}
+
+//  return the slot that holds "cell", or the empty slot where it would go
+template <int DIM, typename Real>
+typename HashGrid<DIM, Real>::CellSlot*
+HashGrid<DIM, Real>::findCell(const Cell& cell)
+{
+    size_t mask = cells_.size() - 1;
+    size_t i = hashCell(cell) & mask;
+    while (cells_[i].head && !sameCell(cells_[i].key, cell)) {
+        i = (i + 1) & mask;
+    }
+    return &cells_[i];
+}
+
+//  double both tables once they are half full
+template <int DIM, typename Real>
+void HashGrid<DIM, Real>::grow()
+{
+    if (2 * data_.size() >= exact_.size()) {
+        std::vector<uint32_t> old(2 * exact_.size(), 0);
+        old.swap(exact_);
+        size_t mask = exact_.size() - 1;
+        for (uint32_t slot : old) {
+            if (!slot) continue;
+            size_t i = hashBits(data_[slot - 1]) & mask;
+            while (exact_[i]) i = (i + 1) & mask;
+            exact_[i] = slot;
+        }
+    }
+    if (useCells() && 2 * numOfCells_ >= cells_.size()) {
+        std::vector<CellSlot> old(2 * cells_.size());
+        old.swap(cells_);
+        for (const CellSlot& slot : old) {
+            if (slot.head) *findCell(slot.key) = slot;
+        }
+    }
+}
+
+template <int DIM, typename Real>
+void HashGrid<DIM, Real>::insert(const Point& point)
+{
+    uint32_t id = data_.size();
+    data_.push_back(point);
+    grow();
+
+    size_t mask = exact_.size() - 1;
+    size_t i = hashBits(point) & mask;
+    while (exact_[i] && !sameBits(data_[exact_[i] - 1], point)) {
+        i = (i + 1) & mask;
+    }
+//  duplicates are only reachable through the cells; the exact table keeps
+//  the first copy
+    if (!exact_[i]) exact_[i] = id + 1;
+
+    next_.push_back(0);
+    if (useCells()) {
+        Cell cell;
+        getCell(point, cell);
+        CellSlot* slot = findCell(cell);
+        if (!slot->head) {
+            std::memcpy(slot->key, cell, sizeof(Cell));
+            numOfCells_++;
+        }
+        next_[id] = slot->head;
+        slot->head = id + 1;
+    }
+}
+
+template <int DIM, typename Real>
+int HashGrid<DIM, Real>::findNearest(const Point& point) const
+{
+//  fast path: the very same coordinates were inserted before
+    size_t mask = exact_.size() - 1;
+    for (size_t i = hashBits(point) & mask; exact_[i]; i = (i + 1) & mask) {
+        if (sameBits(data_[exact_[i] - 1], point)) return exact_[i] - 1;
+    }
+    if (!useCells()) return -1;
+
+//  slow path: scan the 3^DIM cells around the point
+    Cell center, cell;
+    getCell(point, center);
+    int result = -1;
+    Real minDist = std::numeric_limits<Real>::max();
+    int numOfNeighbors = 1;
+    for (int a = 0; a < DIM; a++) numOfNeighbors *= 3;
+    for (int n = 0; n < numOfNeighbors; n++) {
+        for (int a = 0, m = n; a < DIM; a++, m /= 3) {
+            cell[a] = center[a] + (m % 3) - 1;
+        }
+        const CellSlot* slot = findCell(cell);
+        for (uint32_t id = slot->head; id; id = next_[id - 1]) {
+            Real d = Point::get_dist_sqr(point, data_[id - 1]);
+            if (d < minDist || (d == minDist && (int)id - 1 < result)) {
+                minDist = d;
+                result = id - 1;
+            }
+        }
+    }
+//  every point within the radius lies in these cells, so if the nearest
+//  one found is too far away, all of them are
+    if (result >= 0 && double(minDist) > radiusSqr_) {
+        return -1;
+    }
+    return result;
+}
+
+#endif // TYPE_HASHGRID_H_
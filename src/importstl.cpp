@@ -13,79 +13,134 @@
 // You should have received a copy of the GNU General Public License
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
-#include <fstream>
-#include <chrono>
+#include <cstring>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
 #include "importstl.h"
-#include "vectornd.h"
-#include "kdtree.h"
-
-template<typename T>
-T read(std::ifstream& stream)
-{
-    char buffer[sizeof(T)];
-    stream.read(buffer, sizeof(T));
-    return *(T*)buffer;
-}
-
-// specialization
-template<>
-VectorND<> read<VectorND<>>(std::ifstream& stream)
-{
-    return VectorND<>(
-        read<float>(stream),
-        read<float>(stream),
-        read<float>(stream)
-    );
-}
+#include "mappedfile.h"
+#include "inputfile.h"
+#include "gzip.h"
+#include "trianglesoup.h"
+#include "asciistl.h"
+#include "profiler.h"
+
+// binary STL layout: 80-byte header, 32-bit triangle count, then one 50-byte
+// record per triangle (normal, three vertices, 16-bit attribute)
+static const size_t STL_HEADER_SIZE = 84;
+static const size_t STL_RECORD_SIZE = 50;
 
 void ImportSTL::load(Geometry& model)
 {
 //  let's time the STL import
-    auto t0 = std::chrono::high_resolution_clock::now();
-
-    std::ifstream fileSTL (filename_.c_str(), std::ios::in | std::ios::binary);
+    ProfileStage stage("import");
 
-    char header[80];
-    fileSTL.read (header, 80);
+    if (data_) {
+        if (!isGzip(data_, size_)) {
+            loadBuffer(data_, size_, model);
+            return;
+        }
+        std::vector<char> buffer;
+        std::vector<char>& inflated = scratch_ ? *scratch_ : buffer;
+        gunzip(data_, size_, inflated);
+        loadBuffer(inflated.data(), inflated.size(), model);
+        return;
+    }
+    if (mapped_) {
+        ProfileStage read("read");
+        MappedFile file(filename_);
+        Profiler::bytesRead(file.size());
+        if (!isGzip(file.data(), file.size())) {
+            read.stop();
+            loadBuffer(file.data(), file.size(), model);
+        } else {
+            std::vector<char> buffer;
+            try {
+                gunzip(file.data(), file.size(), buffer);
+            } catch (const std::runtime_error& e) {
+                throw std::runtime_error("cannot read \"" + filename_ +
+                    "\": " + e.what());
+            }
+            read.stop();
+            loadBuffer(buffer.data(), buffer.size(), model);
+        }
+    } else {
+//      read the whole file with as few calls as possible, inflating it on
+//      the way if it is compressed
+        ProfileStage read("read");
+        InputFile fileSTL (filename_);
+        std::vector<char> buffer;
+        fileSTL.readAll(buffer);
+        Profiler::bytesRead(buffer.size());
+        read.stop();
+        loadBuffer(buffer.data(), buffer.size(), model);
+    }
 
-    char numStr[4];
-    fileSTL.read(numStr, 4);
-    unsigned numOfTris = *(uint32_t*)numStr;
-    std::cout << "Reading " << numOfTris << " triangles ..." << std::endl;
+    std::cout << "Finished reading STL in " << stage.stop() <<
+        " seconds!" << std::endl;
+}
 
-//  build search tree
-    KDTree<3> tree;
-    for (unsigned i = 0; i < numOfTris; i++) {
-//      read the normal vector but ignore it.
-        auto norm = read<VectorND<>>(fileSTL);
+//  Make room for the welded mesh up front. Every triangle has three face
+//  indices; a closed triangle mesh has about half as many vertices as
+//  triangles, which is also the usual outcome for open CAD meshes.
+static void reserve(size_t numOfTris, Geometry& model)
+{
+    model.faces_.reserve(model.faces_.size() + 3 * numOfTris);
+    model.verts_.reserve(model.verts_.size() + numOfTris / 2 + 3);
+}
 
-        for (unsigned j = 0; j < 3; j++) {
-            unsigned index;
-            auto vec = read<VectorND<>>(fileSTL);
-            int ind = tree.findNearest(vec);
-            if ((ind < 0) || (VectorND<>::get_dist(vec, tree.getPoint(ind)) > 1.0e-8)) {
-                index = tree.size();
-                tree.insert(vec);
-                model.verts_.push_back(vec);
-            } else {
-                index = ind;
-            }
-            model.faces_.push_back(index);
+//  Decode the triangle records where they lie in memory. The size of the
+//  buffer is validated against the triangle count up front, so the welder
+//  never reads past its end. ASCII files are parsed into an array of floats
+//  first and then go through the same welding stage.
+void ImportSTL::loadBuffer(const char* data, size_t size, Geometry& model)
+{
+//  progress messages only for files
+    bool verbose = !data_;
+    if (isAsciiSTL(data, size)) {
+        if (verbose) std::cout << "Parsing ASCII STL ..." << std::endl;
+        ProfileStage parse("parse");
+        std::vector<float> coords = parseAsciiSTL(data, size, weld_.threads);
+        parse.stop();
+        TriangleSoup soup((const char*)coords.data(), 9 * sizeof(float),
+            coords.size() / 9);
+        if (verbose) {
+            std::cout << "Reading " << soup.numOfTris() << " triangles ..." <<
+                std::endl;
         }
-
-//      skip 2 bytes of dummy data
-        char dummy[2];
-        fileSTL.read(dummy, 2);
+        reserve(soup.numOfTris(), model);
+        weld(soup, weld_, model);
+        if (verbose) {
+            std::cout << "Points reduced from " << soup.size() << " to " <<
+                model.verts_.size() << " after merging!" << std::endl;
+        }
+        return;
     }
 
-    std::cout << "Points reduced from " << 3 * numOfTris << " to " << 
-        tree.size() << " after merging!" << std::endl;
+    if (size < STL_HEADER_SIZE) {
+        throw std::runtime_error("\"" + filename_ +
+            "\" is too short to be a binary STL file");
+    }
+    uint32_t numOfTris;
+    std::memcpy(&numOfTris, data + 80, sizeof(uint32_t));
+    if ((size - STL_HEADER_SIZE) / STL_RECORD_SIZE < numOfTris) {
+        throw std::runtime_error("\"" + filename_ + "\" is truncated: " +
+            std::to_string(numOfTris) + " triangles declared but only " +
+            std::to_string((size - STL_HEADER_SIZE) / STL_RECORD_SIZE) +
+            " present");
+    }
+    if (verbose) {
+        std::cout << "Reading " << numOfTris << " triangles ..." << std::endl;
+    }
+    reserve(numOfTris, model);
 
-    std::chrono::duration<double> duration = 
-        std::chrono::high_resolution_clock::now() - t0;
-    std::cout << "Finished reading STL in " << (double)duration.count() <<
-        " seconds!" << std::endl;
-        
+//  skip the normal vector at the start of each record; the corners follow
+    TriangleSoup soup(data + STL_HEADER_SIZE + 3 * sizeof(float),
+        STL_RECORD_SIZE, numOfTris);
+    weld(soup, weld_, model);
 
+    if (verbose) {
+        std::cout << "Points reduced from " << soup.size() << " to " <<
+            model.verts_.size() << " after merging!" << std::endl;
+    }
 }
-
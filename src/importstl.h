@@ -19,21 +19,54 @@
 
 #include <string>
 #include <iostream>
+#include <vector>
 #include "visitor.h"
 #include "geometry.h"
+#include "weld.h"
 
 class ImportSTL : public Visitor<Geometry> {
     std::string filename_;
+//  read the file through a memory mapping instead of a stream
+    bool mapped_;
+//  how coincident corners are merged into shared vertices
+    WeldOptions weld_;
+//  caller-owned file contents, or nullptr to read "filename_"
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+//  where gzip-compressed data is inflated, or nullptr for a local buffer
+    std::vector<char>* scratch_ = nullptr;
 public:
-    ImportSTL(const std::string& filename) : 
-        filename_(filename) {}
+    ImportSTL(const std::string& filename, bool mapped = false,
+        const WeldOptions& weld = WeldOptions()) : 
+        filename_(filename), mapped_(mapped), weld_(weld) {}
+
+//  Import an STL file that is already in memory, possibly gzip-compressed;
+//  compressed data is inflated into "scratch" if given, so a caller can
+//  reuse that buffer. This is a library call, so it prints no progress
+//  messages. (A named function, since a file name given as a C string
+//  would also match a buffer constructor.)
+    static ImportSTL fromMemory(const char* data, size_t size,
+        const WeldOptions& weld = WeldOptions(),
+        std::vector<char>* scratch = nullptr) {
+        ImportSTL import("STL buffer", false, weld);
+        import.data_ = data;
+        import.size_ = size;
+        import.scratch_ = scratch;
+        return import;
+    }
 
     void dispatch(Geometry& model) override {
-        std::cout << "Loading STL file \"" << filename_ << "\"" << std::endl;
+        if (!data_) {
+            std::cout << "Loading STL file \"" << filename_ << "\"" <<
+                std::endl;
+        }
         load(model);
     }
     
     void load(Geometry& model);
+
+private:
+    void loadBuffer(const char* data, size_t size, Geometry& model);
 };
 
 #endif // TYPE_IMPORTSTL_H_
@@ -0,0 +1,98 @@
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+#include "inputfile.h"
+#include "gzip.h"
+
+//  The file is opened here so that its size and first bytes can be looked
+//  at before zlib takes it over; gzread passes plain files through.
+InputFile::InputFile(const std::string& filename) : filename_(filename)
+{
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    struct stat info;
+    if (fd < 0 || ::fstat(fd, &info) != 0) {
+        std::string error = std::strerror(errno);
+        if (fd >= 0) ::close(fd);
+        throw std::runtime_error("cannot open \"" + filename + "\": " + error);
+    }
+    size_ = info.st_size;
+    char magic[2];
+    if (size_ >= 2 && ::pread(fd, magic, 2, 0) == 2 && isGzip(magic, 2)) {
+        compressed_ = true;
+        unsigned char trailer[4] = {};
+        if (size_ >= 4 && ::pread(fd, trailer, 4, size_ - 4) == 4) {
+            size_ = (uint32_t)trailer[0] | ((uint32_t)trailer[1] << 8) |
+                ((uint32_t)trailer[2] << 16) | ((uint32_t)trailer[3] << 24);
+        } else {
+            size_ = 0;
+        }
+    }
+    file_ = gzdopen(fd, "rb");
+    if (!file_) {
+        ::close(fd);
+        throw std::runtime_error("cannot open \"" + filename + "\"");
+    }
+//  large reads, and a large input buffer for inflating
+    gzbuffer((gzFile)file_, 1 << 20);
+}
+
+InputFile::~InputFile()
+{
+    if (file_) gzclose((gzFile)file_);
+}
+
+size_t InputFile::read(char* data, size_t size)
+{
+    size_t done = 0;
+    while (done < size) {
+        unsigned chunk = (unsigned)std::min<size_t>(size - done, INT_MAX);
+        int n = gzread((gzFile)file_, data + done, chunk);
+//      a compressed file that ends early reads as a short file, with an
+//      error code set
+        int code = Z_OK;
+        if (n <= 0) gzerror((gzFile)file_, &code);
+        if (n < 0 || (code != Z_OK && code != Z_STREAM_END)) {
+            throw std::runtime_error("cannot read \"" + filename_ + "\": " +
+                (code == Z_ERRNO ? std::strerror(errno) :
+                code == Z_BUF_ERROR ? "truncated gzip data" :
+                "corrupt gzip data"));
+        }
+        if (n == 0) break;
+        done += n;
+    }
+    return done;
+}
+
+void InputFile::readAll(std::vector<char>& data)
+{
+    size_t used = data.size();
+//  the size is exact for plain files; for compressed ones, it's a start
+    data.resize(used + size_ + 1);
+    while (true) {
+        used += read(data.data() + used, data.size() - used);
+        if (used < data.size()) break;
+        data.resize(2 * data.size());
+    }
+    data.resize(used);
+}
@@ -0,0 +1,64 @@
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TYPE_INPUTFILE_H_
+#define TYPE_INPUTFILE_H_
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Sequential reader of an input file that may be gzip-compressed. Whether
+// it is compressed is told by its first bytes, not by its name; compressed
+// files are inflated as they are read (through zlib), so the whole
+// compressed file is never held in memory, and plain files are read as
+// they are.
+class InputFile {
+    void* file_ = nullptr;  // gzFile
+    std::string filename_;
+    uint64_t size_ = 0;
+    bool compressed_ = false;
+public:
+//  open the file; throws std::runtime_error on failure
+    explicit InputFile(const std::string& filename);
+    ~InputFile();
+
+    InputFile(const InputFile&) = delete;
+    InputFile& operator=(const InputFile&) = delete;
+
+    bool compressed() const { return compressed_; }
+
+//  Size of the contents. For a compressed file it is the size recorded in
+//  the gzip trailer, which is only kept modulo 4 GiB, so it is a hint.
+    uint64_t size() const { return size_; }
+
+//  true if the contents may be "size" bytes long: exactly the size of a
+//  plain file, or the size of a compressed one modulo 4 GiB
+    bool mayHaveSize(uint64_t size) const {
+        return compressed_ ? (size & 0xFFFFFFFFu) == size_ : size == size_;
+    }
+
+//  Read up to "size" bytes and return how many were read, which is less
+//  only at the end of the file. Throws std::runtime_error on an I/O error
+//  or on corrupt compressed data.
+    size_t read(char* data, size_t size);
+
+//  append the rest of the file to "data"
+    void readAll(std::vector<char>& data);
+};
+
+#endif // TYPE_INPUTFILE_H_
@@ -18,10 +18,15 @@
 #ifndef TYPE_KDTREE_H_
 #define TYPE_KDTREE_H_
 
-#include <memory>
+#include <cstdint>
 #include <limits>
 #include <vector>
+#include <utility>
+#include <algorithm>
+#include <thread>
 #include "vectornd.h"
+#include "parallel.h"
+#include "radixsort.h"
 
 template <int DIM, typename Real = double>
 class KDTree {
@@ -29,21 +34,25 @@ class KDTree {
     using Point = VectorND<DIM, Real>;
 
 //  define Node type for private operations on the tree. No one should use
-//  this outside KDTree
-    class Node {
-        Node(int id, int8_t axis = 0) : id_(id), axis_(axis) {}
-        ~Node() { delete left_; delete right_; }
-        Node* left_ = nullptr;
-        Node* right_ = nullptr;
+//  this outside KDTree. Nodes live in a single pool and refer to their
+//  children by 32-bit index, so a node takes 16 bytes and four of them
+//  share a cache line.
+    struct Node {
+        uint32_t left_;
+        uint32_t right_;
         uint32_t id_;
         int8_t axis_;
-        friend class KDTree<DIM, Real>;
     };
 
-    using NodePtr = Node*;
+//  index of a missing child or of the root of an empty tree
+    static const uint32_t NIL = std::numeric_limits<uint32_t>::max();
 
-//  pointer to the root node
-    Node* root_ = nullptr;
+//  pool of all nodes; building or destroying the tree is a single
+//  allocation or deallocation
+    std::vector<Node> nodes_;
+
+//  index of the root node
+    uint32_t root_ = NIL;
 
 //  vector of all points; this can dynamically grow or shrink
 //  Note that this is the sinle data structure for storing points data. The
@@ -52,12 +61,47 @@ class KDTree {
 //  easier to use.
     std::vector<Point> data_;
 
+//  Static snapshot of data_ for batched queries, rebuilt on demand after an
+//  insertion. Its leaves hold up to BUCKET points whose coordinates are
+//  stored axis by axis (structure of arrays), so the distances to a whole
+//  leaf are computed by one vectorizable loop.
+    static const unsigned BUCKET = 8;
+    struct BucketNode {
+        Real split_;      // splitting coordinate of an inner node
+        uint32_t first_;  // inner node: left child; leaf: first point
+        uint32_t second_; // inner node: right child; leaf: number of points
+        int8_t axis_;     // splitting axis, or -1 for a leaf
+    };
+    std::vector<BucketNode> buckets_;
+    std::vector<Real> bucketCoords_[DIM];
+    std::vector<uint32_t> bucketIds_;
+    bool bucketsStale_ = true;
+
+public: // types
+//  Counters of tree activity, for profiling. Visits of findNearestBatch are
+//  bucket-tree nodes, those of findNearest are tree nodes, including the
+//  descent to the would-be parent of the query.
+    struct Stats {
+        uint64_t queries = 0;
+        uint64_t nodesVisited = 0;
+        uint64_t maxNodesVisited = 0; // by any single query
+        uint64_t inserts = 0;
+        uint64_t maxDepth = 0;        // deepest level holding a node
+    };
+
+private:
+    Stats stats_;
+
 public: // methos
 //  default constructor
     KDTree() = default;
 
-//  default destructor
-    ~KDTree() { delete root_; }
+//  Build a balanced tree from a whole point set at once. Every node splits
+//  its subtree at the median along the axis of its level, so the depth is
+//  about log2(n) regardless of the order of the points. The two halves of
+//  the upper levels are built concurrently on up to "threads" threads
+//  (0 means all cores). Points keep their index in "points" as their id.
+    explicit KDTree(std::vector<Point> points, unsigned threads = 0);
 
 //  delete copy constructor, assignment operator, move constructor, and
 //  move assignment operator. we don't want someone accidentally copies a
@@ -72,6 +116,15 @@ public: // methos
 //  get the current size
     size_t size() { return data_.size(); }
 
+//  number of levels of the tree; a leaf-only tree has depth 1
+    size_t depth() const;
+
+//  Renumber the nodes in breadth-first order. The top levels, which every
+//  query visits, then sit next to each other at the front of the pool, and
+//  the two children of a node are adjacent. Worth calling once a tree is
+//  built and about to serve many queries.
+    void layoutBreadthFirst();
+
 //  This function is N^2 so it's very inefficient. It's included only for
 //  testing purpose to confirm the correctness of algorithm. Otherwise,
 //  it shouldn't be used in actual code.
@@ -80,30 +133,162 @@ public: // methos
 //  This function is NlogN, so it should be used in actual code.
     int findNearest(const Point& pt);
 
+//  Find the nearest point to each of "count" query points and store its
+//  index in the corresponding element of "result" (-1 if the tree is
+//  empty). The queries are answered in Morton order, so consecutive lookups
+//  walk the same, cache-resident part of the tree, and each one starts from
+//  the answer to the previous one as an upper bound. Ties are resolved in
+//  favour of the lower index, like findNearestBruteForce. The queries are
+//  split across "threads" threads (0 means all cores).
+    void findNearestBatch(const Point* queries, size_t count, int* result,
+        unsigned threads = 0);
+
+//  Indices of all points within "radius" of "point" (inclusive), in
+//  ascending order. The search is iterative and compares squared distances
+//  only.
+    void findWithinRadius(const Point& point, Real radius,
+        std::vector<int>& result);
+
+//  Indices of the "k" points nearest to "point" (fewer if the tree is
+//  smaller), nearest first; equally distant points are ordered by index,
+//  so the first one is what findNearestBruteForce returns.
+    void findKNearest(const Point& point, size_t k, std::vector<int>& result);
+
 //  return the point from its id
     Point getPoint(int index) {
         return data_[index];
     }
 
+//  activity since construction
+    const Stats& stats() const { return stats_; }
+
 private: // methods
-    int findNearest(Node* node, const Point& point, Real& minDist);
-    Node* getParentNode(const Point& point) const;
+    void buildBuckets();
+    uint32_t buildBuckets(uint32_t* begin, uint32_t* end, int8_t axis);
+    int findNearestBucketed(const Point& point, int guess,
+        uint64_t& visited) const;
+    uint32_t build(uint32_t* ids, uint32_t* begin, uint32_t* end,
+        int8_t axis, unsigned spawn);
+    int findNearest(uint32_t node, const Point& point, Real& minDist);
+    uint32_t getParentNode(const Point& point, uint64_t& depth) const;
 };
 
+template <int DIM, typename Real>
+KDTree<DIM, Real>::KDTree(std::vector<Point> points, unsigned threads) :
+    nodes_(points.size()), data_(std::move(points))
+{
+    std::vector<uint32_t> ids(data_.size());
+    for (uint32_t i = 0; i < ids.size(); i++) ids[i] = i;
+
+//  split into separate threads for the first log2(threads) levels
+    unsigned spawn = 0;
+    for (unsigned t = resolveThreads(threads); t > 1; t /= 2) spawn++;
+    root_ = build(ids.data(), ids.data(), ids.data() + ids.size(), 0, spawn);
+
+//  halving the range at every level gives a depth of bit_width(n)
+    for (size_t n = data_.size(); n > 0; n /= 2) stats_.maxDepth++;
+}
+
+//  Build the subtree of the points whose ids lie in [begin, end). The median
+//  along "axis" becomes the root of the subtree; std::nth_element leaves the
+//  points before it no larger and those after it no smaller, which is all
+//  the search needs. Each level does linear work, hence O(n log n) in total.
+//  The node of the median is stored at the median's position in "ids", so
+//  concurrent subtrees write to disjoint parts of the pool.
+template <int DIM, typename Real>
+uint32_t
+KDTree<DIM, Real>::build(uint32_t* ids, uint32_t* begin, uint32_t* end,
+    int8_t axis, unsigned spawn)
+{
+    if (begin == end) return NIL;
+    uint32_t* median = begin + (end - begin) / 2;
+    std::nth_element(begin, median, end, [this, axis](uint32_t a, uint32_t b) {
+        return data_[a][axis] < data_[b][axis];
+    });
+
+    uint32_t index = median - ids;
+    Node& node = nodes_[index];
+    node.id_ = *median;
+    node.axis_ = axis;
+    int8_t next = (axis + 1) % DIM;
+    if (spawn > 0) {
+        std::thread worker([=, &node] {
+            node.left_ = build(ids, begin, median, next, spawn - 1);
+        });
+        node.right_ = build(ids, median + 1, end, next, spawn - 1);
+        worker.join();
+    } else {
+        node.left_ = build(ids, begin, median, next, 0);
+        node.right_ = build(ids, median + 1, end, next, 0);
+    }
+    return index;
+}
+
+//  walk the tree with an explicit stack, since a tree built by insertion
+//  can be as deep as it has nodes
+template <int DIM, typename Real>
+size_t KDTree<DIM, Real>::depth() const
+{
+    size_t result = 0;
+    std::vector<std::pair<uint32_t, size_t>> stack;
+    if (root_ != NIL) stack.emplace_back(root_, 1);
+    while (!stack.empty()) {
+        auto top = stack.back();
+        stack.pop_back();
+        result = std::max(result, top.second);
+        const Node& node = nodes_[top.first];
+        if (node.left_ != NIL) stack.emplace_back(node.left_, top.second + 1);
+        if (node.right_ != NIL) stack.emplace_back(node.right_, top.second + 1);
+    }
+    return result;
+}
+
+template <int DIM, typename Real>
+void KDTree<DIM, Real>::layoutBreadthFirst()
+{
+    if (root_ == NIL) return;
+    std::vector<Node> sorted;
+    sorted.reserve(nodes_.size());
+    sorted.push_back(nodes_[root_]);
+//  the nodes that are already in "sorted" form the queue; a child is
+//  appended when its parent is dequeued, so its new index is known then
+    for (size_t head = 0; head < sorted.size(); head++) {
+        Node& node = sorted[head];
+        if (node.left_ != NIL) {
+            sorted.push_back(nodes_[node.left_]);
+            node.left_ = sorted.size() - 1;
+        }
+        if (node.right_ != NIL) {
+            sorted.push_back(nodes_[node.right_]);
+            node.right_ = sorted.size() - 1;
+        }
+    }
+    nodes_.swap(sorted);
+    root_ = 0;
+}
+
 template <int DIM, typename Real>
 void KDTree<DIM, Real>::insert(const Point& point) {
     uint32_t id = data_.size();
     data_.push_back(point);
-    if (!root_) {
-        root_ = new Node(0, 0);
-    } else {
-        Node* parent = getParentNode(point);
-        if (data_[id][parent->axis_] <= data_[parent->id_][parent->axis_]) {
-            parent->left_ = new Node(id, (parent->axis_ + 1) % DIM);
+    bucketsStale_ = true;
+    uint64_t depth = 0;
+    uint32_t parent = getParentNode(point, depth);
+    stats_.inserts++;
+    stats_.maxDepth = std::max(stats_.maxDepth, depth + 1);
+    int8_t axis = 0;
+    if (parent != NIL) {
+        Node& node = nodes_[parent];
+        axis = (node.axis_ + 1) % DIM;
+        if (data_[id][node.axis_] <= data_[node.id_][node.axis_]) {
+            node.left_ = nodes_.size();
         } else {
-            parent->right_ = new Node(id, (parent->axis_ + 1) % DIM);
+            node.right_ = nodes_.size();
         }
+    } else {
+        root_ = nodes_.size();
     }
+    nodes_.push_back(Node{NIL, NIL, id, axis});
 }
 
 
@@ -116,11 +301,15 @@ void KDTree<DIM, Real>::insert(const Point& point) {
 template <int DIM, typename Real>
 int KDTree <DIM, Real>::findNearest(const Point& point)
 {
-    Node* parent = getParentNode(point);
-    if (!parent) return -1;
-    Real minDist = Point::get_dist_sqr(point, data_[parent->id_]);
+    uint64_t visited = stats_.nodesVisited;
+    uint32_t parent = getParentNode(point, stats_.nodesVisited);
+    stats_.queries++;
+    if (parent == NIL) return -1;
+    Real minDist = Point::get_dist_sqr(point, data_[nodes_[parent].id_]);
     int better = findNearest(root_, point, minDist);
-    return (better >= 0) ? better : parent->id_;
+    stats_.maxNodesVisited = std::max(stats_.maxNodesVisited,
+        stats_.nodesVisited - visited);
+    return (better >= 0) ? better : nodes_[parent].id_;
 }
 
 //  Find the nearest point in the data set to "point"
@@ -130,28 +319,31 @@ int KDTree <DIM, Real>::findNearest(const Point& point)
 //  search.
 template <int DIM, typename Real>
 int
-KDTree<DIM, Real>::findNearest(Node* node, const Point& point, Real& minDist)
+KDTree<DIM, Real>::findNearest(uint32_t index, const Point& point,
+    Real& minDist)
 {
-    if (!node) return -1;
-    Real d = Point::get_dist_sqr(point, data_[node->id_]);
+    if (index == NIL) return -1;
+    stats_.nodesVisited++;
+    const Node& node = nodes_[index];
+    Real d = Point::get_dist_sqr(point, data_[node.id_]);
 
     int result = -1;
     if (d < minDist) {
-        result = node->id_;
+        result = node.id_;
         minDist = d;
     }
 
-    Real dp = data_[node->id_][node->axis_] - point[node->axis_];
+    Real dp = data_[node.id_][node.axis_] - point[node.axis_];
     if (dp * dp < minDist) {
-        int pt = findNearest(node->left_, point, minDist);
+        int pt = findNearest(node.left_, point, minDist);
         if (pt >= 0) result = pt;
-        pt = findNearest(node->right_, point, minDist);
+        pt = findNearest(node.right_, point, minDist);
         if (pt >= 0) result = pt;
-    } else if (point[node->axis_] <= data_[node->id_][node->axis_]) {
-        int pt = findNearest(node->left_, point, minDist);
+    } else if (point[node.axis_] <= data_[node.id_][node.axis_]) {
+        int pt = findNearest(node.left_, point, minDist);
         if (pt >= 0) result = pt;
     } else {
-        int pt = findNearest(node->right_, point, minDist);
+        int pt = findNearest(node.right_, point, minDist);
         if (pt >= 0) result = pt;
     }
     return result;
@@ -159,23 +351,258 @@ KDTree<DIM, Real>::findNearest(Node* node, const Point& point, Real& minDist)
 
 //  Give a point "point" and a node "node", return the parent node if we were to
 //  insert the point into the tree. This is useful because it gives us the
-//  initial guess about the nearest point in the tree.
+//  initial guess about the nearest point in the tree. "depth" is increased by
+//  the number of nodes on the way down.
 
 template <int DIM, class Real>
-typename KDTree<DIM, Real>::Node*
-KDTree<DIM, Real>::getParentNode(const Point& point) const
+uint32_t
+KDTree<DIM, Real>::getParentNode(const Point& point, uint64_t& depth) const
 {
-    Node* node = root_;
-    Node* parent = nullptr;
-    while (node) {
-        parent = node;
-        node = (point[node->axis_] <= data_[node->id_][node->axis_])
-            ? node->left_ : node->right_;
+    uint32_t index = root_;
+    uint32_t parent = NIL;
+    while (index != NIL) {
+        parent = index;
+        depth++;
+        const Node& node = nodes_[index];
+        index = (point[node.axis_] <= data_[node.id_][node.axis_])
+            ? node.left_ : node.right_;
     }
     return parent;
 }
 
 
+template <int DIM, typename Real>
+void KDTree<DIM, Real>::buildBuckets()
+{
+    bucketIds_.resize(data_.size());
+    for (uint32_t i = 0; i < bucketIds_.size(); i++) bucketIds_[i] = i;
+    buckets_.clear();
+    if (!data_.empty()) {
+        buildBuckets(bucketIds_.data(), bucketIds_.data() + data_.size(), 0);
+    }
+    for (int a = 0; a < DIM; a++) {
+        bucketCoords_[a].resize(data_.size());
+        for (size_t i = 0; i < data_.size(); i++) {
+            bucketCoords_[a][i] = data_[bucketIds_[i]][a];
+        }
+    }
+    bucketsStale_ = false;
+}
+
+//  Same median split as the bulk build, except that it stops at BUCKET
+//  points and leaves them as a contiguous range of bucketIds_. The root is
+//  always node 0.
+template <int DIM, typename Real>
+uint32_t KDTree<DIM, Real>::buildBuckets(uint32_t* begin, uint32_t* end,
+    int8_t axis)
+{
+    uint32_t index = buckets_.size();
+    buckets_.push_back(BucketNode());
+    if (end - begin <= BUCKET) {
+        buckets_[index] = BucketNode{0, uint32_t(begin - bucketIds_.data()),
+            uint32_t(end - begin), -1};
+        return index;
+    }
+    uint32_t* median = begin + (end - begin) / 2;
+    std::nth_element(begin, median, end, [this, axis](uint32_t a, uint32_t b) {
+        return data_[a][axis] < data_[b][axis];
+    });
+    Real split = data_[*median][axis];
+    int8_t next = (axis + 1) % DIM;
+    uint32_t left = buildBuckets(begin, median, next);
+    uint32_t right = buildBuckets(median, end, next);
+    buckets_[index] = BucketNode{split, left, right, axis};
+    return index;
+}
+
+//  Iterative nearest-point search in the bucket tree. "guess" is the id of
+//  some point (or -1), whose distance bounds the search from the start.
+//  Subtrees are skipped only if they are strictly farther than the best
+//  distance, so a tie with a lower id is never missed.
+template <int DIM, typename Real>
+int KDTree<DIM, Real>::findNearestBucketed(const Point& point, int guess,
+    uint64_t& visited) const
+{
+    int best = guess;
+    Real bestDist = (guess >= 0) ? Point::get_dist_sqr(point, data_[guess])
+        : std::numeric_limits<Real>::max();
+
+//  a stack of (node, squared distance to its region along the split axis)
+    std::pair<uint32_t, Real> stack[64];
+    int top = 0;
+    stack[top++] = std::make_pair(0u, Real(0));
+    while (top > 0) {
+        auto entry = stack[--top];
+        if (entry.second > bestDist) continue;
+        const BucketNode* node = &buckets_[entry.first];
+        visited++;
+        while (node->axis_ >= 0) {
+            Real diff = point[node->axis_] - node->split_;
+            uint32_t nearer = (diff < 0) ? node->first_ : node->second_;
+            uint32_t farther = (diff < 0) ? node->second_ : node->first_;
+            stack[top++] = std::make_pair(farther, diff * diff);
+            node = &buckets_[nearer];
+            visited++;
+        }
+
+//      distances to the whole bucket first, then pick the best
+        Real dist[BUCKET];
+        uint32_t first = node->first_, count = node->second_;
+        for (uint32_t j = 0; j < count; j++) {
+            Real d = 0;
+            for (int a = 0; a < DIM; a++) {
+                Real delta = bucketCoords_[a][first + j] - point[a];
+                d += delta * delta;
+            }
+            dist[j] = d;
+        }
+        for (uint32_t j = 0; j < count; j++) {
+            int id = bucketIds_[first + j];
+            if (dist[j] < bestDist || (dist[j] == bestDist && id < best)) {
+                bestDist = dist[j];
+                best = id;
+            }
+        }
+    }
+    return best;
+}
+
+template <int DIM, typename Real>
+void KDTree<DIM, Real>::findNearestBatch(const Point* queries, size_t count,
+    int* result, unsigned threads)
+{
+    if (count == 0) return;
+    if (data_.empty()) {
+        std::fill(result, result + count, -1);
+        return;
+    }
+    if (bucketsStale_) buildBuckets();
+
+//  Morton code of every query within the bounding box of all queries
+    const unsigned BITS = 63 / DIM;
+    Point lo = queries[0], hi = queries[0];
+    for (size_t i = 1; i < count; i++) {
+        for (int a = 0; a < DIM; a++) {
+            lo[a] = std::min(lo[a], queries[i][a]);
+            hi[a] = std::max(hi[a], queries[i][a]);
+        }
+    }
+    std::vector<uint64_t> keys(count);
+    std::vector<uint32_t> order(count);
+    for (size_t i = 0; i < count; i++) {
+        uint64_t cell[DIM];
+        for (int a = 0; a < DIM; a++) {
+            Real extent = hi[a] - lo[a];
+            Real t = (extent > 0) ? (queries[i][a] - lo[a]) / extent : 0;
+            cell[a] = uint64_t(t * ((uint64_t(1) << BITS) - 1));
+        }
+        uint64_t key = 0;
+        for (int b = BITS - 1; b >= 0; b--) {
+            for (int a = 0; a < DIM; a++) {
+                key = (key << 1) | ((cell[a] >> b) & 1);
+            }
+        }
+        keys[i] = key;
+        order[i] = i;
+    }
+    radixSortPairs(keys, order, BITS * DIM, threads);
+
+    unsigned chunks = chunkCount(count, threads, 1024);
+    std::vector<uint64_t> visited(chunks, 0), maxVisited(chunks, 0);
+    parallelChunks(count, chunks, [&](unsigned c, size_t begin, size_t end) {
+        int guess = -1;
+        for (size_t i = begin; i < end; i++) {
+            uint64_t v = 0;
+            guess = findNearestBucketed(queries[order[i]], guess, v);
+            result[order[i]] = guess;
+            visited[c] += v;
+            maxVisited[c] = std::max(maxVisited[c], v);
+        }
+    });
+    stats_.queries += count;
+    for (unsigned c = 0; c < chunks; c++) {
+        stats_.nodesVisited += visited[c];
+        stats_.maxNodesVisited = std::max(stats_.maxNodesVisited,
+            maxVisited[c]);
+    }
+}
+
+//  Depth-first search with an explicit stack of (node, squared distance to
+//  the node's side of its parent's splitting plane). Points equal to a
+//  node's coordinate are inserted to its left, but the right side is still
+//  searched when it is close enough, so nothing on the sphere is missed.
+template <int DIM, typename Real>
+void KDTree<DIM, Real>::findWithinRadius(const Point& point, Real radius,
+    std::vector<int>& result)
+{
+    result.clear();
+    stats_.queries++;
+    if (root_ == NIL) return;
+    const Real r2 = radius * radius;
+    uint64_t visited = 0;
+    std::vector<uint32_t> stack;
+    stack.push_back(root_);
+    while (!stack.empty()) {
+        const Node& node = nodes_[stack.back()];
+        stack.pop_back();
+        visited++;
+        const Point& p = data_[node.id_];
+        if (Point::get_dist_sqr(point, p) <= r2) result.push_back(node.id_);
+        Real dp = point[node.axis_] - p[node.axis_];
+        uint32_t nearer = (dp <= 0) ? node.left_ : node.right_;
+        uint32_t farther = (dp <= 0) ? node.right_ : node.left_;
+        if (farther != NIL && dp * dp <= r2) stack.push_back(farther);
+        if (nearer != NIL) stack.push_back(nearer);
+    }
+    std::sort(result.begin(), result.end());
+    stats_.nodesVisited += visited;
+    stats_.maxNodesVisited = std::max(stats_.maxNodesVisited, visited);
+}
+
+//  The k best (distance, id) pairs so far are kept in a max-heap, whose top
+//  bounds the search once it is full. Subtrees strictly beyond the bound are
+//  skipped, so ties with lower ids are still found.
+template <int DIM, typename Real>
+void KDTree<DIM, Real>::findKNearest(const Point& point, size_t k,
+    std::vector<int>& result)
+{
+    result.clear();
+    stats_.queries++;
+    if (root_ == NIL || k == 0) return;
+    using Candidate = std::pair<Real, int>;
+    std::vector<Candidate> heap;
+    heap.reserve(k + 1);
+    uint64_t visited = 0;
+    std::vector<std::pair<uint32_t, Real>> stack;
+    stack.emplace_back(root_, Real(0));
+    while (!stack.empty()) {
+        auto entry = stack.back();
+        stack.pop_back();
+        if (heap.size() == k && entry.second > heap.front().first) continue;
+        const Node& node = nodes_[entry.first];
+        visited++;
+        const Point& p = data_[node.id_];
+        Candidate candidate(Point::get_dist_sqr(point, p), (int)node.id_);
+        if (heap.size() < k) {
+            heap.push_back(candidate);
+            std::push_heap(heap.begin(), heap.end());
+        } else if (candidate < heap.front()) {
+            std::pop_heap(heap.begin(), heap.end());
+            heap.back() = candidate;
+            std::push_heap(heap.begin(), heap.end());
+        }
+        Real dp = point[node.axis_] - p[node.axis_];
+        uint32_t nearer = (dp <= 0) ? node.left_ : node.right_;
+        uint32_t farther = (dp <= 0) ? node.right_ : node.left_;
+        if (farther != NIL) stack.emplace_back(farther, dp * dp);
+        if (nearer != NIL) stack.emplace_back(nearer, entry.second);
+    }
+    std::sort_heap(heap.begin(), heap.end());
+    for (const auto& c : heap) result.push_back(c.second);
+    stats_.nodesVisited += visited;
+    stats_.maxNodesVisited = std::max(stats_.maxNodesVisited, visited);
+}
+
 // This is just a brute force O(n) search. Use only for testing.
 template <int DIM, typename Real>
 int
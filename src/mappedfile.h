@@ -0,0 +1,42 @@
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TYPE_MAPPEDFILE_H_
+#define TYPE_MAPPEDFILE_H_
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of a whole file. The kernel pages the file in on
+// demand, so the content can be parsed in place without copying it into
+// user-space buffers first.
+class MappedFile {
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+public:
+//  map the file; throws std::runtime_error if it can't be opened or mapped
+    explicit MappedFile(const std::string& filename);
+    ~MappedFile();
+
+//  a mapping owns the address range, so it can't be copied
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+};
+
+#endif // TYPE_MAPPEDFILE_H_
@@ -0,0 +1,40 @@
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "memoryconvert.h"
+#include "importstl.h"
+#include "exportobj.h"
+
+MemoryConvert::MemoryConvert() {}
+
+MemoryConvert::MemoryConvert(const Options& options) : options_(options) {}
+
+void MemoryConvert::convert(const char* data, size_t size, OutputSink& sink)
+{
+//  clear() keeps the capacity of the arrays for the next mesh
+    model_.verts_.clear();
+    model_.faces_.clear();
+    model_.visit(ImportSTL::fromMemory(data, size, options_.weld,
+        &inflated_));
+    model_.visit(ExportOBJ(sink, options_.objectName, options_.precision,
+        options_.weld.threads));
+}
+
+void MemoryConvert::convert(const char* data, size_t size,
+    std::vector<char>& output)
+{
+    BufferSink sink(output);
+    convert(data, size, sink);
+}
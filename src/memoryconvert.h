@@ -0,0 +1,67 @@
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TYPE_MEMORYCONVERT_H_
+#define TYPE_MEMORYCONVERT_H_
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "geometry.h"
+#include "outputsink.h"
+#include "weld.h"
+
+// STL to OBJ conversion for programs that link the stl2obj_core library.
+// The STL file (binary or ASCII, possibly gzip-compressed) is a caller-owned
+// buffer, and the OBJ file goes to an OutputSink (a GzipSink compresses
+// it) or is appended to a byte vector, so no file is touched and nothing is
+// printed. Errors are thrown as std::runtime_error.
+//
+// The welded mesh is kept between calls: converting many files with one
+// object reuses its vertex and face arrays, and the buffer compressed input
+// is inflated into, instead of allocating them again. An object must not be
+// used by two threads at once; use one per thread instead.
+class MemoryConvert {
+public:
+    struct Options {
+//      how corners are welded, and the threads used for it and for output
+        WeldOptions weld;
+//      significant digits of vertex coordinates, 0 for the shortest exact
+        int precision = 0;
+//      name on the "o" line of the OBJ file
+        std::string objectName = "mesh";
+    };
+
+    MemoryConvert();
+    explicit MemoryConvert(const Options& options);
+
+//  convert the STL file in [data, data + size) and write the OBJ file
+    void convert(const char* data, size_t size, OutputSink& sink);
+
+//  same, appending the OBJ file to "output"
+    void convert(const char* data, size_t size, std::vector<char>& output);
+
+//  mesh of the last conversion
+    size_t numOfVerts() const { return model_.verts_.size(); }
+    size_t numOfTris() const { return model_.faces_.size() / 3; }
+
+private:
+    Options options_;
+    Geometry model_;
+    std::vector<char> inflated_;
+};
+
+#endif // TYPE_MEMORYCONVERT_H_
@@ -0,0 +1,181 @@
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+#include "meshadjacency.h"
+#include "parallel.h"
+
+MeshAdjacency::MeshAdjacency(const std::vector<unsigned>& faces,
+    size_t numOfVerts, unsigned threads) : faces_(faces)
+{
+    const size_t n = faces.size() - faces.size() % 3;
+    if (n >= NONMANIFOLD) {
+        throw std::runtime_error("too many triangles for the adjacency table");
+    }
+    const unsigned chunks = chunkCount(n, threads, 1 << 16);
+    const unsigned vertChunks = chunkCount(numOfVerts, threads, 1 << 16);
+
+//  1) number of outgoing half-edges of every vertex
+    std::unique_ptr<std::atomic<uint32_t>[]> count(
+        new std::atomic<uint32_t>[numOfVerts]);
+    parallelChunks(numOfVerts, vertChunks, [&](unsigned, size_t b, size_t e) {
+        for (size_t v = b; v < e; v++) count[v].store(0);
+    });
+    parallelChunks(n, chunks, [&](unsigned, size_t b, size_t e) {
+        for (size_t h = b; h < e; h++) {
+            count[faces[h]].fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+
+//  2) row offsets; the counters become the fill cursors of the rows
+    offset_.resize(numOfVerts + 1);
+    offset_[0] = 0;
+    for (size_t v = 0; v < numOfVerts; v++) {
+        offset_[v + 1] = offset_[v] + count[v].load(std::memory_order_relaxed);
+        count[v].store(offset_[v], std::memory_order_relaxed);
+    }
+
+//  3) fill the rows; with more than one chunk the order within a row
+//     depends on the scheduling of the threads, so the rows are sorted
+    outgoing_.resize(n);
+    parallelChunks(n, chunks, [&](unsigned, size_t b, size_t e) {
+        for (size_t h = b; h < e; h++) {
+            outgoing_[count[faces[h]].fetch_add(1,
+                std::memory_order_relaxed)] = h;
+        }
+    });
+    count.reset();
+    if (chunks > 1) {
+        parallelChunks(numOfVerts, vertChunks, [&](unsigned, size_t b,
+            size_t e) {
+            for (size_t v = b; v < e; v++) {
+                std::sort(outgoing_.begin() + offset_[v],
+                    outgoing_.begin() + offset_[v + 1]);
+            }
+        });
+    }
+
+//  4) twins: the twin of u->v is the only half-edge v->u, provided u->v is
+//     the only half-edge in its own direction. Every row is copied as
+//     (target, half-edge) pairs sorted by target, so the half-edges
+//     between two vertices are found by binary search and the pass is
+//     O(n log d) for vertex degrees d, even at fans of high valence.
+    using Entry = std::pair<uint32_t, uint32_t>;
+    std::vector<Entry> byTarget(n);
+    parallelChunks(numOfVerts, vertChunks, [&](unsigned, size_t b, size_t e) {
+        for (size_t v = b; v < e; v++) {
+            for (uint32_t k = offset_[v]; k < offset_[v + 1]; k++) {
+                byTarget[k] = Entry(target(outgoing_[k]), outgoing_[k]);
+            }
+            std::sort(byTarget.begin() + offset_[v],
+                byTarget.begin() + offset_[v + 1]);
+        }
+    });
+    auto between = [&](unsigned u, unsigned v) {
+        return std::equal_range(byTarget.begin() + offset_[u],
+            byTarget.begin() + offset_[u + 1], Entry(v, 0),
+            [](const Entry& a, const Entry& b) { return a.first < b.first; });
+    };
+    twin_.resize(n);
+    parallelChunks(numOfVerts, vertChunks, [&](unsigned, size_t b, size_t e) {
+        for (size_t u = b; u < e; u++) {
+            for (uint32_t k = offset_[u]; k < offset_[u + 1]; k++) {
+                unsigned v = byTarget[k].first;
+                uint32_t& twin = twin_[byTarget[k].second];
+                if (u == v) {
+                    twin = NONMANIFOLD;
+                    continue;
+                }
+                auto same = between(u, v);
+                auto opposite = between(v, u);
+                size_t numOfSame = same.second - same.first;
+                size_t numOfOpposite = opposite.second - opposite.first;
+                if (numOfSame == 1 && numOfOpposite == 1) {
+                    twin = opposite.first->second;
+                } else if (numOfSame == 1 && numOfOpposite == 0) {
+                    twin = BOUNDARY;
+                } else {
+                    twin = NONMANIFOLD;
+                }
+            }
+        }
+    });
+}
+
+bool MeshAdjacency::hasEdge(unsigned u, unsigned v) const
+{
+    for (const uint32_t* g = outgoingBegin(u); g != outgoingEnd(u); g++) {
+        if (target(*g) == v) return true;
+    }
+    for (const uint32_t* g = outgoingBegin(v); g != outgoingEnd(v); g++) {
+        if (target(*g) == u) return true;
+    }
+    return false;
+}
+
+std::vector<std::vector<uint32_t>> MeshAdjacency::boundaryLoops() const
+{
+    std::vector<std::vector<uint32_t>> loops;
+    std::vector<char> visited(twin_.size(), 0);
+    std::vector<uint32_t> loop;
+    for (size_t start = 0; start < twin_.size(); start++) {
+        if (twin_[start] != BOUNDARY || visited[start]) continue;
+        loop.clear();
+        size_t h = start;
+        bool closed = false;
+        while (true) {
+            visited[h] = 1;
+            loop.push_back(h);
+//          continue with a boundary half-edge leaving the end of this one;
+//          returning to the start closes the loop
+            unsigned v = target(h);
+            size_t following = BOUNDARY;
+            for (const uint32_t* g = outgoingBegin(v); g != outgoingEnd(v);
+                g++) {
+                if (twin_[*g] != BOUNDARY) continue;
+                if (*g == start) {
+                    closed = true;
+                    break;
+                }
+                if (!visited[*g] && following == BOUNDARY) following = *g;
+            }
+            if (closed || following == BOUNDARY) break;
+            h = following;
+        }
+        if (!closed) continue;
+//      A loop through the same vertex twice is pinched there; it is split
+//      into simple loops, each cut off as its start vertex comes round.
+        std::vector<uint32_t> path;
+        std::unordered_map<unsigned, size_t> position;
+        for (uint32_t edge : loop) {
+            auto found = position.find(origin(edge));
+            if (found != position.end()) {
+                loops.emplace_back(path.begin() + found->second, path.end());
+                for (size_t k = found->second; k < path.size(); k++) {
+                    position.erase(origin(path[k]));
+                }
+                path.resize(found->second);
+            }
+            position[origin(edge)] = path.size();
+            path.push_back(edge);
+        }
+        loops.push_back(path);
+    }
+    return loops;
+}
@@ -0,0 +1,82 @@
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TYPE_MESHADJACENCY_H_
+#define TYPE_MESHADJACENCY_H_
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Half-edge connectivity of an indexed triangle mesh, for mesh repair
+// passes. Half-edge h = 3 * t + j runs from corner j to corner (j + 1) % 3
+// of triangle t, so half-edges need no storage of their own; the table only
+// holds, per vertex, the half-edges that start there (compressed rows), and
+// the twin of every half-edge. That is 8 bytes per half-edge plus 4 per
+// vertex. The rows are filled by counting, which hashes every edge to its
+// origin vertex without collisions, and the twin of u->v is found by binary
+// search in the row of v, sorted by target, so the build takes O(n log d)
+// time for n half-edges and vertex degrees d, however high the valence.
+// All steps run in parallel, and the result doesn't depend on the number
+// of threads.
+class MeshAdjacency {
+public:
+//  twin() of an edge that belongs to one triangle only
+    static const uint32_t BOUNDARY = std::numeric_limits<uint32_t>::max();
+//  twin() of an edge shared by more than two triangles, of an edge used
+//  twice in the same direction, and of a degenerate edge u->u
+    static const uint32_t NONMANIFOLD = BOUNDARY - 1;
+
+    MeshAdjacency(const std::vector<unsigned>& faces, size_t numOfVerts,
+        unsigned threads = 0);
+
+    size_t numOfHalfEdges() const { return twin_.size(); }
+
+//  half-edge after h in its triangle
+    static size_t next(size_t h) { return (h % 3 == 2) ? h - 2 : h + 1; }
+
+    unsigned origin(size_t h) const { return faces_[h]; }
+    unsigned target(size_t h) const { return faces_[next(h)]; }
+
+//  the opposite half-edge of h, BOUNDARY or NONMANIFOLD
+    uint32_t twin(size_t h) const { return twin_[h]; }
+
+//  half-edges starting at vertex v, in increasing order
+    const uint32_t* outgoingBegin(unsigned v) const {
+        return outgoing_.data() + offset_[v];
+    }
+    const uint32_t* outgoingEnd(unsigned v) const {
+        return outgoing_.data() + offset_[v + 1];
+    }
+
+//  whether any triangle has an edge between vertices u and v
+    bool hasEdge(unsigned u, unsigned v) const;
+
+//  Closed loops of boundary half-edges, each in the orientation of the
+//  triangles it borders and through every vertex at most once: loops that
+//  touch themselves at a vertex are split there. Chains that can't be
+//  closed, which end at non-manifold edges, are left out.
+    std::vector<std::vector<uint32_t>> boundaryLoops() const;
+
+private:
+    const std::vector<unsigned>& faces_;
+    std::vector<uint32_t> offset_;
+    std::vector<uint32_t> outgoing_;
+    std::vector<uint32_t> twin_;
+};
+
+#endif // TYPE_MESHADJACENCY_H_
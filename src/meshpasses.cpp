@@ -0,0 +1,36 @@
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "meshpasses.h"
+#include "stitchcurves.h"
+#include "fillholes.h"
+#include "optimizecache.h"
+
+std::string MeshPasses::describe() const
+{
+    std::string passes;
+    if (stitchCurves) passes += " stitch-curves";
+    if (fillHoles) passes += " fill-holes";
+    if (optimize) passes += " optimize";
+    return passes.empty() ? "none" : passes.substr(1);
+}
+
+void runMeshPasses(Geometry& model, const MeshPasses& passes,
+    unsigned threads)
+{
+    if (passes.stitchCurves) model.visit(StitchCurves(0.0, threads));
+    if (passes.fillHoles) model.visit(FillHoles(threads));
+    if (passes.optimize) model.visit(OptimizeVertexCache());
+}
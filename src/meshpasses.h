@@ -0,0 +1,43 @@
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TYPE_MESHPASSES_H_
+#define TYPE_MESHPASSES_H_
+#pragma once
+
+#include <string>
+#include "geometry.h"
+
+// Optional passes over the welded mesh between import and export. They
+// need the whole mesh in memory, so out-of-core conversions can't run them.
+struct MeshPasses {
+//  close cracks and T-junctions along curves between surfaces
+    bool stitchCurves = false;
+//  close holes bounded by a single loop of edges
+    bool fillHoles = false;
+//  reorder triangles and vertices for vertex caches
+    bool optimize = false;
+
+    bool any() const { return stitchCurves || fillHoles || optimize; }
+
+//  the enabled passes, for cache keys
+    std::string describe() const;
+};
+
+// Run the enabled passes on "model", repairs before reordering.
+void runMeshPasses(Geometry& model, const MeshPasses& passes,
+    unsigned threads = 0);
+
+#endif // TYPE_MESHPASSES_H_
@@ -0,0 +1,148 @@
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cstdint>
+#include <limits>
+#include "optimizecache.h"
+#include "profiler.h"
+
+double computeACMR(const std::vector<unsigned>& faces, size_t numOfVerts,
+    unsigned cacheSize)
+{
+    size_t numOfTris = faces.size() / 3;
+    if (numOfTris == 0) return 0.0;
+//  a vertex is cached if fewer than cacheSize misses happened since it
+//  was loaded, which is exactly FIFO replacement
+    const uint64_t NEVER = std::numeric_limits<uint64_t>::max();
+    std::vector<uint64_t> loadedAt(numOfVerts, NEVER);
+    uint64_t misses = 0;
+    for (unsigned v : faces) {
+        if (loadedAt[v] == NEVER || misses - loadedAt[v] >= cacheSize) {
+            loadedAt[v] = misses++;
+        }
+    }
+    return (double)misses / numOfTris;
+}
+
+//  Tipsify: fan around one vertex at a time, emitting all of its remaining
+//  triangles. The next fanning vertex is one of the vertices just emitted
+//  that has triangles left and will still be in the cache once they are
+//  emitted; among those, the one that entered the cache first. If there is
+//  none, the most recently emitted vertex with triangles left is taken
+//  (dead-end stack), or else the next such vertex in index order.
+void OptimizeVertexCache::optimize(Geometry& model)
+{
+    ProfileStage stage("optimize");
+    const std::vector<unsigned>& faces = model.faces_;
+    const size_t numOfTris = faces.size() / 3;
+    const size_t numOfVerts = model.verts_.size();
+    const int64_t k = cacheSize_;
+    if (numOfTris == 0) return;
+    double before = computeACMR(faces, numOfVerts, cacheSize_);
+
+//  triangles around every vertex (compressed rows); "live" counts those not
+//  emitted yet
+    std::vector<uint32_t> live(numOfVerts, 0);
+    for (unsigned v : faces) live[v]++;
+    std::vector<size_t> offset(numOfVerts + 1, 0);
+    for (size_t v = 0; v < numOfVerts; v++) offset[v + 1] = offset[v] + live[v];
+    std::vector<uint32_t> adjacent(faces.size());
+    {
+        std::vector<size_t> fill(offset.begin(), offset.end() - 1);
+        for (size_t i = 0; i < faces.size(); i++) {
+            adjacent[fill[faces[i]]++] = i / 3;
+        }
+    }
+
+    std::vector<int64_t> cachedAt(numOfVerts, 0);
+    std::vector<char> emitted(numOfTris, 0);
+    std::vector<unsigned> deadEnd;
+    std::vector<unsigned> candidates;
+    std::vector<unsigned> result;
+    result.reserve(faces.size());
+    int64_t time = k + 1;
+    size_t cursor = 0;
+    auto skipDeadEnd = [&]() -> int64_t {
+        while (!deadEnd.empty()) {
+            unsigned v = deadEnd.back();
+            deadEnd.pop_back();
+            if (live[v] > 0) return v;
+        }
+        for (; cursor < numOfVerts; cursor++) {
+            if (live[cursor] > 0) return cursor;
+        }
+        return -1;
+    };
+
+    int64_t fan = skipDeadEnd();
+    while (fan >= 0) {
+        candidates.clear();
+        for (size_t a = offset[fan]; a < offset[fan + 1]; a++) {
+            uint32_t t = adjacent[a];
+            if (emitted[t]) continue;
+            emitted[t] = 1;
+            for (unsigned j = 0; j < 3; j++) {
+                unsigned v = faces[3 * t + j];
+                result.push_back(v);
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                live[v]--;
+                if (time - cachedAt[v] > k) cachedAt[v] = time++;
+            }
+        }
+
+        fan = -1;
+        int64_t best = -1;
+        for (unsigned v : candidates) {
+            if (live[v] == 0) continue;
+            int64_t priority = 0;
+            if (time - cachedAt[v] + 2 * (int64_t)live[v] <= k) {
+                priority = time - cachedAt[v];
+            }
+            if (priority > best) {
+                best = priority;
+                fan = v;
+            }
+        }
+        if (fan < 0) fan = skipDeadEnd();
+    }
+
+//  renumber the vertices in order of first use
+    const unsigned UNUSED = std::numeric_limits<unsigned>::max();
+    std::vector<unsigned> newIndex(numOfVerts, UNUSED);
+    unsigned next = 0;
+    for (unsigned& v : result) {
+        if (newIndex[v] == UNUSED) newIndex[v] = next++;
+        v = newIndex[v];
+    }
+    for (size_t v = 0; v < numOfVerts; v++) {
+        if (newIndex[v] == UNUSED) newIndex[v] = next++;
+    }
+    Geometry::VertexStore verts;
+    verts.resize(numOfVerts);
+    for (size_t v = 0; v < numOfVerts; v++) {
+        verts.set(newIndex[v], model.verts_[v]);
+    }
+    model.verts_ = std::move(verts);
+    model.faces_.swap(result);
+
+    double after = computeACMR(model.faces_, numOfVerts, cacheSize_);
+    Profiler::count("optimize.acmr_before_x1000", (uint64_t)(before * 1000));
+    Profiler::count("optimize.acmr_after_x1000", (uint64_t)(after * 1000));
+    std::cout << "Cache misses per triangle (ACMR) changed from " << before <<
+        " to " << after << " after reordering!" << std::endl;
+    std::cout << "Finished optimizing in " << stage.stop() << " seconds!" <<
+        std::endl;
+}
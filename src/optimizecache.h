@@ -0,0 +1,54 @@
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TYPE_OPTIMIZECACHE_H_
+#define TYPE_OPTIMIZECACHE_H_
+#pragma once
+
+#include <cstddef>
+#include <iostream>
+#include <vector>
+#include "visitor.h"
+#include "geometry.h"
+
+// Reorders the triangles of a welded mesh for the post-transform vertex
+// cache of a GPU, using Tipsify (Sander, Nehab and Barczak, 2007), and then
+// renumbers the vertices in order of first use, so vertex fetches walk
+// memory forward. The mesh itself is unchanged: every triangle keeps its
+// corners in the same cyclic order, and so its orientation.
+class OptimizeVertexCache : public Visitor<Geometry> {
+//  number of entries of the cache that the order is tuned for
+    unsigned cacheSize_;
+public:
+    explicit OptimizeVertexCache(unsigned cacheSize = 16) :
+        cacheSize_(cacheSize) {}
+
+    void dispatch(Geometry& model) override {
+        std::cout << "Optimizing triangle order for a vertex cache of " <<
+            cacheSize_ << " entries ..." << std::endl;
+        optimize(model);
+    }
+
+    void optimize(Geometry& model);
+};
+
+// Average cache miss ratio: the number of vertices a FIFO cache of
+// "cacheSize" entries has to load per triangle when the triangles are
+// drawn in order. It is 3 at worst, and about 0.5 for a regular mesh in
+// the best possible order.
+double computeACMR(const std::vector<unsigned>& faces, size_t numOfVerts,
+    unsigned cacheSize = 16);
+
+#endif // TYPE_OPTIMIZECACHE_H_
@@ -0,0 +1,68 @@
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <stdexcept>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "outputfile.h"
+
+OutputFile::OutputFile(const std::string& filename) : filename_(filename)
+{
+    fd_ = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd_ < 0) {
+        throw std::runtime_error("cannot create \"" + filename + "\": " +
+            std::strerror(errno));
+    }
+    struct stat info;
+    regular_ = ::fstat(fd_, &info) == 0 && S_ISREG(info.st_mode);
+}
+
+OutputFile::~OutputFile()
+{
+    if (fd_ >= 0) ::close(fd_);
+}
+
+void OutputFile::write(const char* data, size_t size)
+{
+//  write() may accept only part of a large block
+    while (size > 0) {
+        ssize_t done = ::write(fd_, data, size);
+        if (done < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error("cannot write \"" + filename_ + "\": " +
+                std::strerror(errno));
+        }
+        data += done;
+        size -= done;
+    }
+}
+
+void OutputFile::writeAt(const char* data, size_t size, uint64_t offset)
+{
+    while (size > 0) {
+        ssize_t done = ::pwrite(fd_, data, size, offset);
+        if (done < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error("cannot write \"" + filename_ + "\": " +
+                std::strerror(errno));
+        }
+        data += done;
+        size -= done;
+        offset += done;
+    }
+}
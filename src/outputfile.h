@@ -0,0 +1,51 @@
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TYPE_OUTPUTFILE_H_
+#define TYPE_OUTPUTFILE_H_
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "outputsink.h"
+
+// Unbuffered output file. Callers hand it large blocks that they have
+// formatted themselves, so there is no point in a second layer of buffering
+// (or in flushing line by line).
+class OutputFile : public OutputSink {
+    int fd_ = -1;
+    std::string filename_;
+//  only regular files can seek; pipes, terminals and /dev/stdout cannot
+    bool regular_ = false;
+public:
+//  create or truncate the file; throws std::runtime_error on failure
+    explicit OutputFile(const std::string& filename);
+    ~OutputFile() override;
+
+    OutputFile(const OutputFile&) = delete;
+    OutputFile& operator=(const OutputFile&) = delete;
+
+//  append a block at the current position
+    void write(const char* data, size_t size) override;
+
+//  Write a block at "offset" without moving the current position. Blocks
+//  at disjoint offsets may be written from several threads at once. Only
+//  available for regular files; callers write other outputs in order.
+    bool writesAt() const override { return regular_; }
+    void writeAt(const char* data, size_t size, uint64_t offset) override;
+};
+
+#endif // TYPE_OUTPUTFILE_H_
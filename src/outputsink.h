@@ -0,0 +1,62 @@
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TYPE_OUTPUTSINK_H_
+#define TYPE_OUTPUTSINK_H_
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+// Destination of an exported file: a file on disk (OutputFile), memory
+// (BufferSink), or anything else a caller wants to stream the bytes to.
+// Writers hand it large blocks in file order.
+class OutputSink {
+public:
+    virtual ~OutputSink() {}
+
+//  append a block
+    virtual void write(const char* data, size_t size) = 0;
+
+//  Write out anything the sink holds back. Writers call it once, after
+//  their last block.
+    virtual void flush() {}
+
+//  Sinks that can write blocks at given offsets, from several threads at
+//  once, return true here and implement writeAt.
+    virtual bool writesAt() const { return false; }
+    virtual void writeAt(const char*, size_t, uint64_t) {
+        throw std::logic_error("sink can't write at an offset");
+    }
+};
+
+// Appends to a caller-owned byte vector, which keeps its capacity between
+// conversions if the caller clears it rather than freeing it.
+class BufferSink : public OutputSink {
+    std::vector<char>& buffer_;
+public:
+    explicit BufferSink(std::vector<char>& buffer) : buffer_(buffer) {}
+
+    void write(const char* data, size_t size) override {
+        size_t at = buffer_.size();
+        buffer_.resize(at + size);
+        std::memcpy(buffer_.data() + at, data, size);
+    }
+};
+
+#endif // TYPE_OUTPUTSINK_H_
@@ -0,0 +1,80 @@
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TYPE_PARALLEL_H_
+#define TYPE_PARALLEL_H_
+#pragma once
+
+#include <cstddef>
+#include <algorithm>
+#include <exception>
+#include <thread>
+#include <vector>
+
+// number of threads to use when the user doesn't specify it (0 means "all")
+inline unsigned resolveThreads(unsigned threads)
+{
+    if (threads > 0) return threads;
+    unsigned hw = std::thread::hardware_concurrency();
+    return hw ? hw : 1;
+}
+
+// Number of chunks to split a range of "n" items into. Each chunk gets at
+// least "grain" items, so small inputs don't pay for spawning threads.
+inline unsigned chunkCount(size_t n, unsigned threads, size_t grain = 4096)
+{
+    size_t byGrain = (n + grain - 1) / grain;
+    return (unsigned)std::max<size_t>(1,
+        std::min<size_t>(resolveThreads(threads), byGrain));
+}
+
+// first item of chunk "c" when [0, n) is split into "chunks" even pieces
+inline size_t chunkBegin(size_t n, unsigned chunks, unsigned c)
+{
+    return n * c / chunks;
+}
+
+// Split [0, n) into "chunks" contiguous pieces and call fn(c, begin, end) for
+// each of them concurrently. The calling thread runs chunk 0 itself. Chunks
+// are numbered in range order, so per-chunk results can be combined in a
+// deterministic way no matter how many threads were used. If any chunk
+// throws, the exception of the lowest such chunk is rethrown once all
+// chunks are done.
+template <typename Func>
+void parallelChunks(size_t n, unsigned chunks, Func fn)
+{
+    if (chunks <= 1) {
+        fn(0u, (size_t)0, n);
+        return;
+    }
+    std::vector<std::exception_ptr> errors(chunks);
+    auto run = [&](unsigned c) {
+        try {
+            fn(c, chunkBegin(n, chunks, c), chunkBegin(n, chunks, c + 1));
+        } catch (...) {
+            errors[c] = std::current_exception();
+        }
+    };
+    std::vector<std::thread> pool;
+    pool.reserve(chunks - 1);
+    for (unsigned c = 1; c < chunks; c++) pool.emplace_back(run, c);
+    run(0);
+    for (auto& t : pool) t.join();
+    for (auto& e : errors) {
+        if (e) std::rethrow_exception(e);
+    }
+}
+
+#endif // TYPE_PARALLEL_H_
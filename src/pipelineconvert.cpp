@@ -0,0 +1,348 @@
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "pipelineconvert.h"
+#include "spscqueue.h"
+#include "asciistl.h"
+#include "trianglesoup.h"
+#include "geometry.h"
+#include "weld.h"
+#include "inputfile.h"
+#include "outputfile.h"
+#include "gzip.h"
+#include "textbuffer.h"
+#include "chunkwriter.h"
+#include "exportply.h"
+#include "profiler.h"
+
+namespace {
+
+using Point = Geometry::Point;
+using Clock = std::chrono::steady_clock;
+
+// triangles and vertices per batch, and batches in flight between stages
+const size_t BATCH_TRIS = 1 << 14;
+const size_t BATCH_VERTS = 1 << 14;
+const size_t POOL_SIZE = 4;
+
+// layout of binary STL, as in ImportSTL
+const size_t STL_HEADER_SIZE = 84;
+const size_t STL_RECORD_SIZE = 50;
+
+// Triangle records as read from the file: binary STL records, or 9 floats
+// per triangle for ASCII files.
+struct TriangleBatch {
+    std::vector<char> bytes;
+    size_t stride = 0;
+    size_t offset = 0;  // of the first corner within a record
+    size_t numOfTris = 0;
+
+    TriangleSoup soup() const {
+        return TriangleSoup(bytes.data() + offset, stride, numOfTris);
+    }
+};
+
+// coordinates of new vertices, in the order of their numbers
+struct VertexBatch {
+    std::vector<float> xyz;
+};
+
+// A fixed set of buffers cycling between a producer and a consumer stage:
+// empty ones go back to the producer through "free", filled ones on to the
+// consumer through "full".
+template <typename Batch>
+struct BatchPipe {
+    std::vector<Batch> pool;
+    SpscQueue<Batch*> free;
+    SpscQueue<Batch*> full;
+
+    BatchPipe() : pool(POOL_SIZE), free(POOL_SIZE), full(POOL_SIZE) {
+        for (Batch& batch : pool) free.push(&batch);
+    }
+
+//  stop both directions, so that neither side waits for the other
+    void close() {
+        free.close();
+        full.close();
+    }
+};
+
+double seconds(Clock::duration time)
+{
+    return std::chrono::duration<double>(time).count();
+}
+
+//  Stream binary records from "file", which is positioned after the header,
+//  in batches; compressed files are inflated batch by batch. Returns early
+//  if the welder has given up.
+void readBinary(InputFile& file, uint32_t numOfTris,
+    BatchPipe<TriangleBatch>& pipe, Clock::duration& busy)
+{
+    TriangleBatch* batch;
+    for (uint32_t done = 0; done < numOfTris; ) {
+        if (!pipe.free.pop(batch)) return;
+        auto t0 = Clock::now();
+        size_t count = std::min<size_t>(BATCH_TRIS, numOfTris - done);
+        batch->bytes.resize(BATCH_TRIS * STL_RECORD_SIZE);
+        batch->stride = STL_RECORD_SIZE;
+//      skip the normal vector at the start of each record
+        batch->offset = 3 * sizeof(float);
+        batch->numOfTris = count;
+        if (file.read(batch->bytes.data(), count * STL_RECORD_SIZE) <
+            count * STL_RECORD_SIZE) {
+            throw std::runtime_error("STL file is truncated");
+        }
+        done += count;
+        busy += Clock::now() - t0;
+        if (!pipe.full.push(batch)) return;
+    }
+}
+
+//  An ASCII file has to be parsed before its triangle count is known, so it
+//  is parsed in one go; welding and writing still overlap with the copies
+//  into batches.
+void readAscii(InputFile& file, const char* header, size_t headerSize,
+    unsigned threads, BatchPipe<TriangleBatch>& pipe, Clock::duration& busy)
+{
+    auto t0 = Clock::now();
+    std::vector<char> text(header, header + headerSize);
+    file.readAll(text);
+    std::vector<float> coords = parseAsciiSTL(text.data(), text.size(),
+        threads);
+    std::vector<char>().swap(text);
+    busy += Clock::now() - t0;
+
+    const size_t record = 9 * sizeof(float);
+    size_t numOfTris = coords.size() / 9;
+    TriangleBatch* batch;
+    for (size_t done = 0; done < numOfTris; ) {
+        if (!pipe.free.pop(batch)) return;
+        t0 = Clock::now();
+        size_t count = std::min(BATCH_TRIS, numOfTris - done);
+        batch->bytes.resize(BATCH_TRIS * record);
+        batch->stride = record;
+        batch->offset = 0;
+        batch->numOfTris = count;
+        std::memcpy(batch->bytes.data(), &coords[9 * done], count * record);
+        done += count;
+        busy += Clock::now() - t0;
+        if (!pipe.full.push(batch)) return;
+    }
+}
+
+//  Format and write vertex lines until the welder closes the pipe.
+void writeVertices(ChunkWriter& writer, int precision,
+    BatchPipe<VertexBatch>& pipe, Clock::duration& busy)
+{
+    TextBuffer text (1 << 20);
+    VertexBatch* batch;
+    while (pipe.full.pop(batch)) {
+        auto t0 = Clock::now();
+        text.clear();
+        for (size_t i = 0; i < batch->xyz.size(); i += 3) {
+            text.append("v ");
+            for (unsigned a = 0; a < 3; a++) {
+                text.appendReal(batch->xyz[i + a], precision);
+                text.append(' ');
+            }
+            text.append("1.0\n");
+        }
+        writer.append(text);
+        busy += Clock::now() - t0;
+        if (!pipe.free.push(batch)) return;
+    }
+}
+
+} // namespace
+
+void PipelineConvert::convert(const std::string& input,
+    const std::string& output)
+{
+    if (isPLYFile(output)) {
+        throw std::runtime_error("pipelined conversion writes OBJ files only");
+    }
+    ProfileStage stage("pipeline");
+
+    InputFile fileSTL (input);
+    char header[STL_HEADER_SIZE];
+    size_t headerSize = fileSTL.read(header, STL_HEADER_SIZE);
+    uint64_t fileSize = fileSTL.size();
+//  a gzip file records its size modulo 4 GiB only; trust the size that the
+//  binary header implies if it agrees
+    if (headerSize == STL_HEADER_SIZE) {
+        uint32_t declared;
+        std::memcpy(&declared, header + 80, sizeof(uint32_t));
+        uint64_t implied = STL_HEADER_SIZE +
+            STL_RECORD_SIZE * (uint64_t)declared;
+        if (fileSTL.mayHaveSize(implied)) fileSize = implied;
+    }
+
+    bool ascii = isAsciiSTL(header, headerSize, fileSize);
+    uint32_t numOfTris = 0;
+    if (ascii) {
+        std::cout << "Parsing ASCII STL ..." << std::endl;
+    } else {
+        if (fileSize < STL_HEADER_SIZE) {
+            throw std::runtime_error("\"" + input +
+                "\" is too short to be a binary STL file");
+        }
+        std::memcpy(&numOfTris, header + 80, sizeof(uint32_t));
+        if ((fileSize - STL_HEADER_SIZE) / STL_RECORD_SIZE < numOfTris) {
+            throw std::runtime_error("\"" + input + "\" is truncated: " +
+                std::to_string(numOfTris) + " triangles declared but only " +
+                std::to_string((fileSize - STL_HEADER_SIZE) /
+                STL_RECORD_SIZE) + " present");
+        }
+        std::cout << "Reading " << numOfTris << " triangles ..." << std::endl;
+    }
+
+    OutputFile fileOBJ (output);
+    std::unique_ptr<GzipSink> compressed;
+    if (isGzipFile(output)) {
+        compressed.reset(new GzipSink(fileOBJ, options_.threads));
+    }
+    OutputSink& sink = compressed ? *compressed : (OutputSink&)fileOBJ;
+    ChunkWriter writer (sink, options_.threads);
+    TextBuffer text;
+    text.append("# Object name\n");
+    text.append("o ");
+    text.append(stripGzipSuffix(output).c_str());
+    text.append("\n\n");
+    text.append("# Begin list of vertices\n");
+    writer.append(text);
+
+    BatchPipe<TriangleBatch> triangles;
+    BatchPipe<VertexBatch> vertices;
+    std::exception_ptr readError, weldError, writeError;
+    Clock::duration readBusy{}, weldBusy{}, writeBusy{};
+
+//  a stage that ends, normally or not, closes the pipes it feeds
+    std::thread reader([&] {
+        try {
+            if (ascii) {
+                readAscii(fileSTL, header, headerSize, options_.threads,
+                    triangles, readBusy);
+            } else {
+                readBinary(fileSTL, numOfTris, triangles, readBusy);
+            }
+        } catch (...) {
+            readError = std::current_exception();
+        }
+        triangles.full.close();
+    });
+    std::thread vertexWriter([&] {
+        try {
+            writeVertices(writer, options_.precision, vertices, writeBusy);
+        } catch (...) {
+            writeError = std::current_exception();
+        }
+        vertices.close();
+    });
+
+//  the calling thread welds
+    KDTreeWelder welder(options_.tolerance);
+    std::vector<unsigned> faces;
+    faces.reserve(3 * (size_t)numOfTris);
+    uint64_t corners = 0;
+    try {
+        VertexBatch* out = nullptr;
+        TriangleBatch* batch;
+        bool open = vertices.free.pop(out);
+        if (open) out->xyz.clear();
+        while (open && triangles.full.pop(batch)) {
+            auto t0 = Clock::now();
+            TriangleSoup soup = batch->soup();
+            for (size_t i = 0; i < soup.size(); i++) {
+                auto vec = soup.corner<float>(i);
+                size_t numOfVerts = welder.size();
+                unsigned ind = welder.add(Point(vec[0], vec[1], vec[2]));
+                if (welder.size() > numOfVerts) {
+                    for (unsigned a = 0; a < 3; a++) out->xyz.push_back(vec[a]);
+                    if (out->xyz.size() == 3 * BATCH_VERTS) {
+                        open = vertices.full.push(out) &&
+                            vertices.free.pop(out);
+                        if (!open) break;
+                        out->xyz.clear();
+                    }
+                }
+                faces.push_back(ind);
+            }
+            corners += soup.size();
+            weldBusy += Clock::now() - t0;
+            if (!triangles.free.push(batch)) break;
+        }
+        if (open && !out->xyz.empty()) vertices.full.push(out);
+    } catch (...) {
+        weldError = std::current_exception();
+    }
+    triangles.close();
+    vertices.full.close();
+    reader.join();
+    vertexWriter.join();
+    if (readError) std::rethrow_exception(readError);
+    if (weldError) std::rethrow_exception(weldError);
+    if (writeError) std::rethrow_exception(writeError);
+    std::cout << "Points reduced from " << corners << " to " <<
+        welder.size() << " after merging!" << std::endl;
+
+    text.clear();
+    text.append("# End list of vertices\n");
+    text.append("\n");
+    text.append("# Begin list of faces\n");
+    writer.append(text);
+
+    writer.appendItems(faces.size() / 3, [&](TextBuffer& buf, size_t i) {
+        buf.append("f ");
+        for (unsigned j = 0; j < 3; j++) {
+            buf.appendUInt(faces[3 * i + j] + 1);
+            buf.append(' ');
+        }
+        buf.append('\n');
+    });
+
+    text.clear();
+    text.append("# End list of faces\n");
+    text.append("\n");
+    writer.append(text);
+    sink.flush();
+
+    Profiler::bytesRead(fileSize);
+    Profiler::bytesWritten(writer.offset());
+    Profiler::count("weld.corners", corners);
+    Profiler::count("weld.vertices", welder.size());
+    Profiler::count("weld.merges", corners - welder.size());
+    welder.profile();
+//  busy time of every stage, and how often it waited for its neighbours:
+//  the reader for free batches, the welder and the writer for input
+    Profiler::count("pipeline.read_us", (uint64_t)(seconds(readBusy) * 1.0e6));
+    Profiler::count("pipeline.weld_us", (uint64_t)(seconds(weldBusy) * 1.0e6));
+    Profiler::count("pipeline.write_us",
+        (uint64_t)(seconds(writeBusy) * 1.0e6));
+    Profiler::count("pipeline.read_stalls", triangles.free.consumerStalls());
+    Profiler::count("pipeline.weld_stalls", triangles.full.consumerStalls());
+    Profiler::count("pipeline.write_stalls", vertices.full.consumerStalls());
+    std::cout << "Finished pipelined conversion in " << stage.stop() <<
+        " seconds!" << std::endl;
+}
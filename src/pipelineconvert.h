@@ -0,0 +1,59 @@
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TYPE_PIPELINECONVERT_H_
+#define TYPE_PIPELINECONVERT_H_
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+//  STL to OBJ conversion as three concurrent stages instead of one after
+//  the other:
+//  1) A reader thread reads the input in batches of triangles and hands
+//     them on through a bounded lock-free queue (SpscQueue).
+//  2) The welder merges the corners of every batch into a K-D forest as
+//     they arrive. A vertex gets its final number when it first appears, so
+//     new vertices flow on right away, through a second queue.
+//  3) A writer thread formats and writes the vertex lines while the rest of
+//     the file is still being read and welded.
+//  Buffers cycle between neighbouring stages, so the memory in flight is a
+//  few batches, and the conversion takes about as long as its slowest stage
+//  rather than the sum of all of them. Only the face indices are held until
+//  the end, since faces follow the vertices in an OBJ file; they are then
+//  written on "threads" threads. Vertices are numbered in order of first
+//  appearance, so the output is byte-identical to importing with the K-D
+//  tree welder and exporting with ExportOBJ.
+class PipelineConvert {
+public:
+    struct Options {
+//      corners that are at most this far apart are merged
+        double tolerance = 1.0e-8;
+//      significant digits of vertex coordinates, 0 for the shortest exact
+        int precision = 0;
+//      threads that format the faces; 0 uses all cores
+        unsigned threads = 0;
+    };
+
+    explicit PipelineConvert(const Options& options) : options_(options) {}
+
+//  convert an STL file (binary or ASCII) into an OBJ file
+    void convert(const std::string& input, const std::string& output);
+
+private:
+    Options options_;
+};
+
+#endif // TYPE_PIPELINECONVERT_H_
@@ -0,0 +1,183 @@
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <stdexcept>
+#include <sys/resource.h>
+#include "profiler.h"
+
+//  Allocation totals, fed by a program that replaces the global operator
+//  new (see stl2obj.cpp). The library itself leaves operator new alone, so
+//  programs that link it keep their own allocator; without the hook, the
+//  totals stay zero.
+static std::atomic<uint64_t> numOfAllocations(0);
+static std::atomic<uint64_t> numOfAllocatedBytes(0);
+
+void Profiler::recordAllocation(size_t size)
+{
+    numOfAllocations.fetch_add(1, std::memory_order_relaxed);
+    numOfAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+static thread_local Profiler* currentProfiler = nullptr;
+
+Profiler* Profiler::current()
+{
+    return currentProfiler;
+}
+
+void Profiler::install(Profiler* profiler)
+{
+    currentProfiler = profiler;
+}
+
+void Profiler::count(const char* name, uint64_t n)
+{
+    if (currentProfiler) currentProfiler->counters_[name] += n;
+}
+
+void Profiler::maximum(const char* name, uint64_t value)
+{
+    if (currentProfiler) {
+        uint64_t& counter = currentProfiler->counters_[name];
+        if (counter < value) counter = value;
+        currentProfiler->maxima_.insert(name);
+    }
+}
+
+void Profiler::bytesRead(uint64_t n)
+{
+    if (currentProfiler && !currentProfiler->open_.empty()) {
+        currentProfiler->stages_[currentProfiler->open_.back()].bytesRead += n;
+    }
+}
+
+void Profiler::bytesWritten(uint64_t n)
+{
+    if (currentProfiler && !currentProfiler->open_.empty()) {
+        currentProfiler->stages_[currentProfiler->open_.back()].bytesWritten +=
+            n;
+    }
+}
+
+uint64_t Profiler::allocations()
+{
+    return numOfAllocations.load(std::memory_order_relaxed);
+}
+
+uint64_t Profiler::allocatedBytes()
+{
+    return numOfAllocatedBytes.load(std::memory_order_relaxed);
+}
+
+uint64_t Profiler::peakRss()
+{
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+//  Linux reports kilobytes
+    return (uint64_t)usage.ru_maxrss * 1024;
+}
+
+//  Stage names and counter names are identifiers chosen by the code, so
+//  they need no escaping.
+void Profiler::writeJSON(std::ostream& out) const
+{
+    out << "{\n  \"stages\": [";
+    for (size_t i = 0; i < stages_.size(); i++) {
+        const Stage& s = stages_[i];
+        out << (i ? "," : "") << "\n    {\"name\": \"" << s.name <<
+            "\", \"depth\": " << s.depth <<
+            ", \"seconds\": " << s.seconds <<
+            ", \"bytes_read\": " << s.bytesRead <<
+            ", \"bytes_written\": " << s.bytesWritten <<
+            ", \"allocations\": " << s.allocations <<
+            ", \"allocated_bytes\": " << s.allocatedBytes <<
+            ", \"peak_rss\": " << s.peakRss << "}";
+    }
+    out << "\n  ],\n  \"counters\": {";
+    bool first = true;
+    for (const auto& counter : counters_) {
+        out << (first ? "" : ",") << "\n    \"" << counter.first << "\": " <<
+            counter.second;
+        first = false;
+    }
+    out << "\n  },\n  \"allocations\": " << allocations() <<
+        ",\n  \"allocated_bytes\": " << allocatedBytes() <<
+        ",\n  \"peak_rss\": " << peakRss() << "\n}\n";
+}
+
+void Profiler::merge(const Profiler& other)
+{
+    int depth = open_.size();
+    for (Stage stage : other.stages_) {
+        stage.depth += depth;
+        stages_.push_back(stage);
+    }
+    for (const auto& counter : other.counters_) {
+        uint64_t& value = counters_[counter.first];
+        if (other.maxima_.count(counter.first)) {
+            value = std::max(value, counter.second);
+            maxima_.insert(counter.first);
+        } else {
+            value += counter.second;
+        }
+    }
+}
+
+void Profiler::save(const std::string& filename) const
+{
+    std::ofstream file(filename);
+    if (!file) throw std::runtime_error("cannot write \"" + filename + "\"");
+    writeJSON(file);
+}
+
+ProfileStage::ProfileStage(const char* name) :
+    profiler_(Profiler::current()),
+    start_(std::chrono::steady_clock::now()),
+    allocations_(Profiler::allocations()),
+    allocatedBytes_(Profiler::allocatedBytes())
+{
+    if (profiler_) {
+        Profiler::Stage stage;
+        stage.name = name;
+        stage.depth = profiler_->open_.size();
+        index_ = profiler_->stages_.size();
+        profiler_->stages_.push_back(stage);
+        profiler_->open_.push_back(index_);
+    }
+}
+
+double ProfileStage::stop()
+{
+    if (!running_) return seconds_;
+    running_ = false;
+    std::chrono::duration<double> duration =
+        std::chrono::steady_clock::now() - start_;
+    seconds_ = duration.count();
+    if (profiler_) {
+        Profiler::Stage& stage = profiler_->stages_[index_];
+        stage.seconds = seconds_;
+        stage.allocations = Profiler::allocations() - allocations_;
+        stage.allocatedBytes = Profiler::allocatedBytes() - allocatedBytes_;
+        stage.peakRss = Profiler::peakRss();
+//      stages end in reverse order of their start
+        if (!profiler_->open_.empty() && profiler_->open_.back() == index_) {
+            profiler_->open_.pop_back();
+        }
+    }
+    return seconds_;
+}
@@ -0,0 +1,130 @@
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TYPE_PROFILER_H_
+#define TYPE_PROFILER_H_
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <set>
+#include <string>
+#include <vector>
+
+// Per-stage measurements and named event counters of a conversion.
+//
+// Code is instrumented unconditionally: stages are opened with ProfileStage
+// and events are reported through the static functions below. Both go to
+// the profiler installed for the calling thread, and cost next to nothing
+// when there is none. Worker threads have no profiler of their own, so
+// parallel code adds up its counts and reports them from the calling
+// thread.
+class Profiler {
+public:
+    struct Stage {
+        std::string name;
+        int depth = 0;              // nesting level; 0 for top-level stages
+        double seconds = 0.0;       // wall time
+        uint64_t bytesRead = 0;
+        uint64_t bytesWritten = 0;
+        uint64_t allocations = 0;   // calls to operator new during the stage
+        uint64_t allocatedBytes = 0;
+        uint64_t peakRss = 0;       // peak resident set of the process so
+                                    // far, in bytes, when the stage ended
+    };
+
+    Profiler() = default;
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+//  the profiler of the calling thread, or nullptr
+    static Profiler* current();
+
+//  make "profiler" (possibly nullptr) the profiler of the calling thread
+    static void install(Profiler* profiler);
+
+//  add "n" to counter "name"
+    static void count(const char* name, uint64_t n = 1);
+
+//  raise counter "name" to "value" if it is lower
+    static void maximum(const char* name, uint64_t value);
+
+//  attribute I/O to the innermost open stage
+    static void bytesRead(uint64_t n);
+    static void bytesWritten(uint64_t n);
+
+//  Count an allocation of "size" bytes. A program calls this from its
+//  replacement of the global operator new; it is thread-safe and cheap.
+    static void recordAllocation(size_t size);
+
+//  process-wide totals
+    static uint64_t allocations();
+    static uint64_t allocatedBytes();
+    static uint64_t peakRss();
+
+    const std::vector<Stage>& stages() const { return stages_; }
+    const std::map<std::string, uint64_t>& counters() const {
+        return counters_;
+    }
+
+//  Add the stages and counters of "other", typically the profiler of a
+//  worker thread, as if they had been recorded here: its stages nest in
+//  the stages that are open here, counters add up and maxima take the
+//  larger value.
+    void merge(const Profiler& other);
+
+//  report of all stages and counters as a JSON object
+    void writeJSON(std::ostream& out) const;
+    void save(const std::string& filename) const;
+
+private:
+    friend class ProfileStage;
+
+    std::vector<Stage> stages_;
+//  indices of the stages that are still open, innermost last
+    std::vector<size_t> open_;
+    std::map<std::string, uint64_t> counters_;
+//  names of the counters that are maxima rather than sums
+    std::set<std::string> maxima_;
+};
+
+// Scoped stage: measures from construction to stop() or destruction,
+// whichever comes first. The elapsed time is available without a profiler,
+// so the console messages are based on it too.
+class ProfileStage {
+public:
+    explicit ProfileStage(const char* name);
+    ~ProfileStage() { stop(); }
+
+    ProfileStage(const ProfileStage&) = delete;
+    ProfileStage& operator=(const ProfileStage&) = delete;
+
+//  end the stage and return its wall time in seconds
+    double stop();
+
+private:
+    Profiler* profiler_;
+    size_t index_ = 0;
+    bool running_ = true;
+    double seconds_ = 0.0;
+    std::chrono::steady_clock::time_point start_;
+    uint64_t allocations_;
+    uint64_t allocatedBytes_;
+};
+
+#endif // TYPE_PROFILER_H_
@@ -0,0 +1,81 @@
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TYPE_RADIXSORT_H_
+#define TYPE_RADIXSORT_H_
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "parallel.h"
+
+//  Sort (key, value) pairs by the low "keyBits" bits of the key.
+//  This is a least-significant-digit radix sort with 8-bit digits. Each pass
+//  is split across threads: every chunk builds a histogram of its own slice,
+//  a prefix sum over (digit, chunk) gives each chunk a private range of
+//  output slots, and then all chunks scatter concurrently. Chunks are taken
+//  in range order, so the sort is stable and its result doesn't depend on
+//  the number of threads. Passes in which every key has the same digit are
+//  skipped.
+template <typename Value>
+void radixSortPairs(std::vector<uint64_t>& keys, std::vector<Value>& values,
+    unsigned keyBits, unsigned threads)
+{
+    const size_t n = keys.size();
+    const unsigned RADIX = 256;
+    unsigned chunks = chunkCount(n, threads, 1 << 16);
+
+    std::vector<uint64_t> keysTmp(n);
+    std::vector<Value> valuesTmp(n);
+    std::vector<size_t> hist(chunks * RADIX);
+
+    for (unsigned shift = 0; shift < keyBits; shift += 8) {
+        std::fill(hist.begin(), hist.end(), 0);
+        parallelChunks(n, chunks, [&](unsigned c, size_t begin, size_t end) {
+            size_t* h = &hist[c * RADIX];
+            for (size_t i = begin; i < end; i++) {
+                h[(keys[i] >> shift) & (RADIX - 1)]++;
+            }
+        });
+
+//      turn the histograms into starting offsets, digit-major
+        size_t sum = 0;
+        bool trivial = false;
+        for (unsigned d = 0; d < RADIX; d++) {
+            size_t digitTotal = 0;
+            for (unsigned c = 0; c < chunks; c++) {
+                size_t count = hist[c * RADIX + d];
+                hist[c * RADIX + d] = sum;
+                sum += count;
+                digitTotal += count;
+            }
+            if (digitTotal == n) trivial = true;
+        }
+        if (trivial) continue;
+
+        parallelChunks(n, chunks, [&](unsigned c, size_t begin, size_t end) {
+            size_t* offset = &hist[c * RADIX];
+            for (size_t i = begin; i < end; i++) {
+                size_t pos = offset[(keys[i] >> shift) & (RADIX - 1)]++;
+                keysTmp[pos] = keys[i];
+                valuesTmp[pos] = values[i];
+            }
+        });
+        keys.swap(keysTmp);
+        values.swap(valuesTmp);
+    }
+}
+
+#endif // TYPE_RADIXSORT_H_
@@ -0,0 +1,174 @@
+// stl2obj converts an STL CAD file to OBJ format.
+
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TYPE_SEGMENTBVH_H_
+#define TYPE_SEGMENTBVH_H_
+#pragma once
+
+#include <cstdint>
+#include <algorithm>
+#include <vector>
+#include "vectornd.h"
+
+// Bounding volume hierarchy over line segments, for finding the segments
+// that pass within a given distance of a point. It is built once, top down,
+// splitting at the median centre along the longest side of each box, so it
+// is balanced whatever the order of the segments, and a query visits
+// O(log n) nodes plus those whose boxes actually come near the point.
+// Nodes are stored in depth-first order: the left child of a node follows
+// it directly, and only the right child needs an index.
+template <int DIM, typename Real = double>
+class SegmentBVH {
+public:
+    using Point = VectorND<DIM, Real>;
+
+    struct Segment {
+        Point a;
+        Point b;
+        uint32_t id;    // caller's number of the segment
+    };
+
+    SegmentBVH() = default;
+
+    explicit SegmentBVH(std::vector<Segment> segments, unsigned leafSize = 4) :
+        segments_(std::move(segments)), leafSize_(std::max(1u, leafSize))
+    {
+        if (segments_.empty()) return;
+        nodes_.reserve(2 * segments_.size() / leafSize_ + 1);
+        build(0, segments_.size());
+    }
+
+    size_t size() const { return segments_.size(); }
+
+//  Call fn(segment, t, dist2) for every segment whose closest point to "p"
+//  is within "radius"; the closest point is a + t (b - a), at squared
+//  distance dist2.
+    template <typename Func>
+    void forEachNear(const Point& p, double radius, Func fn) const
+    {
+        if (nodes_.empty()) return;
+        const double r2 = radius * radius;
+        uint32_t stack[64];
+        unsigned top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            uint32_t index = stack[--top];
+            const Node& node = nodes_[index];
+            if (boxDistSqr(node, p) > r2) continue;
+            if (node.right_ == LEAF) {
+                for (uint32_t i = node.begin_; i < node.end_; i++) {
+                    double t;
+                    double d2 = segmentDistSqr(p, segments_[i], t);
+                    if (d2 <= r2) fn(segments_[i], t, d2);
+                }
+                continue;
+            }
+            stack[top++] = node.right_;
+            stack[top++] = index + 1;
+        }
+    }
+
+//  squared distance from p to segment s, and the parameter t in [0, 1] of
+//  the closest point
+    static double segmentDistSqr(const Point& p, const Segment& s, double& t)
+    {
+        double ab2 = 0.0, apab = 0.0;
+        for (int k = 0; k < DIM; k++) {
+            double ab = double(s.b[k]) - double(s.a[k]);
+            ab2 += ab * ab;
+            apab += (double(p[k]) - double(s.a[k])) * ab;
+        }
+        t = (ab2 > 0.0) ? std::min(1.0, std::max(0.0, apab / ab2)) : 0.0;
+        double d2 = 0.0;
+        for (int k = 0; k < DIM; k++) {
+            double q = double(s.a[k]) + t * (double(s.b[k]) - double(s.a[k]));
+            d2 += (double(p[k]) - q) * (double(p[k]) - q);
+        }
+        return d2;
+    }
+
+private:
+    static const uint32_t LEAF = 0;
+
+    struct Node {
+        Real lo_[DIM];
+        Real hi_[DIM];
+        uint32_t begin_;
+        uint32_t end_;
+        uint32_t right_;    // LEAF, as the root is never a right child
+    };
+
+    std::vector<Segment> segments_;
+    std::vector<Node> nodes_;
+    unsigned leafSize_ = 4;
+
+    static double boxDistSqr(const Node& node, const Point& p)
+    {
+        double d2 = 0.0;
+        for (int k = 0; k < DIM; k++) {
+            double d = std::max(0.0, std::max(double(node.lo_[k]) - p[k],
+                double(p[k]) - node.hi_[k]));
+            d2 += d * d;
+        }
+        return d2;
+    }
+
+//  build the subtree over segments [begin, end) and return its root
+    uint32_t build(size_t begin, size_t end)
+    {
+        uint32_t index = nodes_.size();
+        nodes_.emplace_back();
+        Node node;
+        node.begin_ = begin;
+        node.end_ = end;
+        node.right_ = LEAF;
+        for (int k = 0; k < DIM; k++) {
+            const Segment& first = segments_[begin];
+            node.lo_[k] = std::min(first.a[k], first.b[k]);
+            node.hi_[k] = std::max(first.a[k], first.b[k]);
+        }
+        for (size_t i = begin + 1; i < end; i++) {
+            for (int k = 0; k < DIM; k++) {
+                node.lo_[k] = std::min({node.lo_[k], segments_[i].a[k],
+                    segments_[i].b[k]});
+                node.hi_[k] = std::max({node.hi_[k], segments_[i].a[k],
+                    segments_[i].b[k]});
+            }
+        }
+        if (end - begin > leafSize_) {
+            int axis = 0;
+            for (int k = 1; k < DIM; k++) {
+                if (node.hi_[k] - node.lo_[k] >
+                    node.hi_[axis] - node.lo_[axis]) {
+                    axis = k;
+                }
+            }
+            size_t mid = begin + (end - begin) / 2;
+            std::nth_element(segments_.begin() + begin,
+                segments_.begin() + mid, segments_.begin() + end,
+                [axis](const Segment& s, const Segment& r) {
+                    return s.a[axis] + s.b[axis] < r.a[axis] + r.b[axis];
+                });
+            build(begin, mid);
+            node.right_ = build(mid, end);
+        }
+        nodes_[index] = node;
+        return index;
+    }
+};
+
+#endif // TYPE_SEGMENTBVH_H_
@@ -0,0 +1,303 @@
+// stl2obj converts an STL CAD file to OBJ format.
+
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cstring>
+#include <limits>
+#include "simdkernels.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define STL2OBJ_X86_DISPATCH 1
+#endif
+
+namespace {
+
+//  scalar versions; std::min/std::max argument order keeps the first value
+//  on NaN, which the vector versions reproduce
+
+template <typename Real>
+void distSqrScalar(const Real* x, const Real* y, const Real* z,
+    size_t count, const Real point[3], Real* out)
+{
+    for (size_t i = 0; i < count; i++) {
+        Real dx = point[0] - x[i], dy = point[1] - y[i], dz = point[2] - z[i];
+        Real d = dx * dx;
+        d += dy * dy;
+        d += dz * dz;
+        out[i] = d;
+    }
+}
+
+inline float loadFloat(const char* p)
+{
+    float f;
+    std::memcpy(&f, p, sizeof(f));
+    return f;
+}
+
+void foldBounds(const float* lo9, const float* hi9, float lo[3], float hi[3])
+{
+    for (unsigned a = 0; a < 3; a++) {
+        lo[a] = std::numeric_limits<float>::max();
+        hi[a] = -std::numeric_limits<float>::max();
+        for (unsigned c = 0; c < 3; c++) {
+            if (lo9[3 * c + a] < lo[a]) lo[a] = lo9[3 * c + a];
+            if (hi9[3 * c + a] > hi[a]) hi[a] = hi9[3 * c + a];
+        }
+    }
+}
+
+//  one accumulator per float of the record, folded into axes at the end
+void recordBoundsScalar(const char* base, size_t stride, size_t count,
+    float lo[3], float hi[3])
+{
+    float lo9[9], hi9[9];
+    for (unsigned k = 0; k < 9; k++) {
+        lo9[k] = std::numeric_limits<float>::max();
+        hi9[k] = -std::numeric_limits<float>::max();
+    }
+    for (size_t i = 0; i < count; i++) {
+        const char* record = base + i * stride;
+        for (unsigned k = 0; k < 9; k++) {
+            float v = loadFloat(record + 4 * k);
+            if (v < lo9[k]) lo9[k] = v;
+            if (v > hi9[k]) hi9[k] = v;
+        }
+    }
+    foldBounds(lo9, hi9, lo, hi);
+}
+
+#ifdef __SSE2__
+
+void distSqrSSE2(const float* x, const float* y, const float* z,
+    size_t count, const float point[3], float* out)
+{
+    const __m128 px = _mm_set1_ps(point[0]);
+    const __m128 py = _mm_set1_ps(point[1]);
+    const __m128 pz = _mm_set1_ps(point[2]);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 dx = _mm_sub_ps(px, _mm_loadu_ps(x + i));
+        __m128 dy = _mm_sub_ps(py, _mm_loadu_ps(y + i));
+        __m128 dz = _mm_sub_ps(pz, _mm_loadu_ps(z + i));
+        __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx),
+            _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+        _mm_storeu_ps(out + i, d);
+    }
+    distSqrScalar(x + i, y + i, z + i, count - i, point, out + i);
+}
+
+void distSqrSSE2(const double* x, const double* y, const double* z,
+    size_t count, const double point[3], double* out)
+{
+    const __m128d px = _mm_set1_pd(point[0]);
+    const __m128d py = _mm_set1_pd(point[1]);
+    const __m128d pz = _mm_set1_pd(point[2]);
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128d dx = _mm_sub_pd(px, _mm_loadu_pd(x + i));
+        __m128d dy = _mm_sub_pd(py, _mm_loadu_pd(y + i));
+        __m128d dz = _mm_sub_pd(pz, _mm_loadu_pd(z + i));
+        __m128d d = _mm_add_pd(_mm_add_pd(_mm_mul_pd(dx, dx),
+            _mm_mul_pd(dy, dy)), _mm_mul_pd(dz, dz));
+        _mm_storeu_pd(out + i, d);
+    }
+    distSqrScalar(x + i, y + i, z + i, count - i, point, out + i);
+}
+
+//  floats 0-3 and 4-7 of each record in two registers, float 8 scalar;
+//  min(v, acc) returns acc if v is NaN, like the scalar comparison
+void recordBoundsSSE2(const char* base, size_t stride, size_t count,
+    float lo[3], float hi[3])
+{
+    __m128 lo0 = _mm_set1_ps(std::numeric_limits<float>::max());
+    __m128 lo1 = lo0;
+    __m128 hi0 = _mm_set1_ps(-std::numeric_limits<float>::max());
+    __m128 hi1 = hi0;
+    float lo8 = std::numeric_limits<float>::max();
+    float hi8 = -lo8;
+    for (size_t i = 0; i < count; i++) {
+        const char* record = base + i * stride;
+        __m128 v0 = _mm_loadu_ps((const float*)record);
+        __m128 v1 = _mm_loadu_ps((const float*)(record + 16));
+        lo0 = _mm_min_ps(v0, lo0);
+        lo1 = _mm_min_ps(v1, lo1);
+        hi0 = _mm_max_ps(v0, hi0);
+        hi1 = _mm_max_ps(v1, hi1);
+        float v8 = loadFloat(record + 32);
+        if (v8 < lo8) lo8 = v8;
+        if (v8 > hi8) hi8 = v8;
+    }
+    float lo9[9], hi9[9];
+    _mm_storeu_ps(lo9, lo0);
+    _mm_storeu_ps(lo9 + 4, lo1);
+    _mm_storeu_ps(hi9, hi0);
+    _mm_storeu_ps(hi9 + 4, hi1);
+    lo9[8] = lo8;
+    hi9[8] = hi8;
+    foldBounds(lo9, hi9, lo, hi);
+}
+
+#endif // __SSE2__
+
+#ifdef STL2OBJ_X86_DISPATCH
+
+__attribute__((target("avx2")))
+void distSqrAVX2(const float* x, const float* y, const float* z,
+    size_t count, const float point[3], float* out)
+{
+    const __m256 px = _mm256_set1_ps(point[0]);
+    const __m256 py = _mm256_set1_ps(point[1]);
+    const __m256 pz = _mm256_set1_ps(point[2]);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 dx = _mm256_sub_ps(px, _mm256_loadu_ps(x + i));
+        __m256 dy = _mm256_sub_ps(py, _mm256_loadu_ps(y + i));
+        __m256 dz = _mm256_sub_ps(pz, _mm256_loadu_ps(z + i));
+        __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx),
+            _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+        _mm256_storeu_ps(out + i, d);
+    }
+    distSqrScalar(x + i, y + i, z + i, count - i, point, out + i);
+}
+
+__attribute__((target("avx2")))
+void distSqrAVX2(const double* x, const double* y, const double* z,
+    size_t count, const double point[3], double* out)
+{
+    const __m256d px = _mm256_set1_pd(point[0]);
+    const __m256d py = _mm256_set1_pd(point[1]);
+    const __m256d pz = _mm256_set1_pd(point[2]);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d dx = _mm256_sub_pd(px, _mm256_loadu_pd(x + i));
+        __m256d dy = _mm256_sub_pd(py, _mm256_loadu_pd(y + i));
+        __m256d dz = _mm256_sub_pd(pz, _mm256_loadu_pd(z + i));
+        __m256d d = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx),
+            _mm256_mul_pd(dy, dy)), _mm256_mul_pd(dz, dz));
+        _mm256_storeu_pd(out + i, d);
+    }
+    distSqrScalar(x + i, y + i, z + i, count - i, point, out + i);
+}
+
+//  floats 0-7 of each record in one register, float 8 scalar
+__attribute__((target("avx2")))
+void recordBoundsAVX2(const char* base, size_t stride, size_t count,
+    float lo[3], float hi[3])
+{
+    __m256 lo0 = _mm256_set1_ps(std::numeric_limits<float>::max());
+    __m256 hi0 = _mm256_set1_ps(-std::numeric_limits<float>::max());
+    float lo8 = std::numeric_limits<float>::max();
+    float hi8 = -lo8;
+    for (size_t i = 0; i < count; i++) {
+        const char* record = base + i * stride;
+        __m256 v = _mm256_loadu_ps((const float*)record);
+        lo0 = _mm256_min_ps(v, lo0);
+        hi0 = _mm256_max_ps(v, hi0);
+        float v8 = loadFloat(record + 32);
+        if (v8 < lo8) lo8 = v8;
+        if (v8 > hi8) hi8 = v8;
+    }
+    float lo9[9], hi9[9];
+    _mm256_storeu_ps(lo9, lo0);
+    _mm256_storeu_ps(hi9, hi0);
+    lo9[8] = lo8;
+    hi9[8] = hi8;
+    foldBounds(lo9, hi9, lo, hi);
+}
+
+bool hasAVX2()
+{
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+}
+
+#endif // STL2OBJ_X86_DISPATCH
+
+//  the best version the build and the processor allow
+template <typename Scalar, typename SSE2, typename AVX2>
+auto select(Scalar scalar, SSE2 sse2, AVX2 avx2)
+{
+#ifdef STL2OBJ_X86_DISPATCH
+    if (hasAVX2()) return avx2;
+#else
+    (void)avx2;
+#endif
+#ifdef __SSE2__
+    (void)scalar;
+    return sse2;
+#else
+    (void)sse2;
+    return scalar;
+#endif
+}
+
+using DistSqrF = void (*)(const float*, const float*, const float*, size_t,
+    const float*, float*);
+using DistSqrD = void (*)(const double*, const double*, const double*, size_t,
+    const double*, double*);
+using RecordBounds = void (*)(const char*, size_t, size_t, float*, float*);
+
+#if defined(STL2OBJ_X86_DISPATCH)
+#define AVX2_OR(f) f##AVX2
+#else
+#define AVX2_OR(f) f##Scalar
+#endif
+#ifdef __SSE2__
+#define SSE2_OR(f) f##SSE2
+#else
+#define SSE2_OR(f) f##Scalar
+#endif
+
+} // namespace
+
+void distSqrBatch(const float* x, const float* y, const float* z,
+    size_t count, const float point[3], float* out)
+{
+    static const DistSqrF kernel = select<DistSqrF, DistSqrF, DistSqrF>(
+        distSqrScalar<float>, SSE2_OR(distSqr), AVX2_OR(distSqr));
+    kernel(x, y, z, count, point, out);
+}
+
+void distSqrBatch(const double* x, const double* y, const double* z,
+    size_t count, const double point[3], double* out)
+{
+    static const DistSqrD kernel = select<DistSqrD, DistSqrD, DistSqrD>(
+        distSqrScalar<double>, SSE2_OR(distSqr), AVX2_OR(distSqr));
+    kernel(x, y, z, count, point, out);
+}
+
+void recordBounds(const char* base, size_t stride, size_t count,
+    float lo[3], float hi[3])
+{
+    static const RecordBounds kernel = select<RecordBounds, RecordBounds,
+        RecordBounds>(recordBoundsScalar, SSE2_OR(recordBounds),
+        AVX2_OR(recordBounds));
+    kernel(base, stride, count, lo, hi);
+}
+
+const char* simdLevel()
+{
+#ifdef STL2OBJ_X86_DISPATCH
+    if (hasAVX2()) return "avx2";
+#endif
+#ifdef __SSE2__
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,53 @@
+// stl2obj converts an STL CAD file to OBJ format.
+
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TYPE_SIMDKERNELS_H_
+#define TYPE_SIMDKERNELS_H_
+#pragma once
+
+#include <cstddef>
+
+// Batch kernels for the hot loops of point searches and bulk passes. Each
+// has a scalar version, an SSE2 version where the compiler targets it, and
+// an AVX2 version that is picked at run time if the processor supports it.
+// All versions round exactly like the scalar code (no fused multiply-add),
+// so results never depend on the machine.
+//
+// Only these batch kernels are vectorized. VectorND<3, float> and
+// VectorND<3, double> keep their scalar loops, as three coordinates fill
+// less than a register, and a padded four-wide point would change the
+// layout that VertexStore, the STL readers and the K-D trees share. Padded
+// types and a transform kernel are left until a pass needs them; the
+// converter transforms no coordinates.
+
+// out[i] = squared distance from "point" to point i, whose coordinates are
+// x[i], y[i] and z[i]; summed in axis order, like VectorND::get_dist_sqr
+void distSqrBatch(const float* x, const float* y, const float* z,
+    size_t count, const float point[3], float* out);
+void distSqrBatch(const double* x, const double* y, const double* z,
+    size_t count, const double point[3], double* out);
+
+// Bounding box of the corners of "count" triangle records of "stride" bytes
+// that start with 9 floats (x, y, z of three corners), as TriangleSoup
+// reads them. NaN coordinates are ignored; lo > hi if there are no corners.
+void recordBounds(const char* base, size_t stride, size_t count,
+    float lo[3], float hi[3]);
+
+// instruction set the kernels run on: "avx2", "sse2" or "scalar"
+const char* simdLevel();
+
+#endif // TYPE_SIMDKERNELS_H_
@@ -0,0 +1,104 @@
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TYPE_SPSCQUEUE_H_
+#define TYPE_SPSCQUEUE_H_
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+// Bounded lock-free queue between exactly one producer thread and one
+// consumer thread. It is a ring of slots indexed by two ever-growing
+// counters: the producer alone advances "tail_" and the consumer alone
+// advances "head_", so each side only ever reads the other's counter, and
+// the release/acquire pair on a counter publishes the slots behind it.
+// The counters live on separate cache lines so the two threads don't
+// bounce one line between their cores.
+//
+// A side that finds the queue full (or empty) yields its time slice until
+// the other side catches up, and counts that as a stall. Either side may
+// close the queue: the producer once it has pushed its last item, or the
+// consumer when it gives up, so that a blocked producer doesn't wait
+// forever.
+template <typename T>
+class SpscQueue {
+public:
+//  capacity is rounded up to a power of two
+    explicit SpscQueue(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity) size *= 2;
+        slots_.resize(size);
+        mask_ = size - 1;
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+//  Append "item", waiting while the queue is full. Returns false, without
+//  appending, if the queue has been closed.
+    bool push(const T& item) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        while (tail - head_.load(std::memory_order_acquire) > mask_) {
+            if (closed()) return false;
+            producerStalls_++;
+            std::this_thread::yield();
+        }
+        if (closed()) return false;
+        slots_[tail & mask_] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+//  Remove the oldest item into "item", waiting while the queue is empty.
+//  Returns false once the queue is closed and drained.
+    bool pop(T& item) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        while (tail_.load(std::memory_order_acquire) == head) {
+            if (closed()) {
+//              the last push may have landed just before the close
+                if (tail_.load(std::memory_order_acquire) != head) break;
+                return false;
+            }
+            consumerStalls_++;
+            std::this_thread::yield();
+        }
+        item = slots_[head & mask_];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    void close() { closed_.store(true, std::memory_order_release); }
+    bool closed() const { return closed_.load(std::memory_order_acquire); }
+
+//  number of times push found the queue full and pop found it empty; each
+//  is only to be read by its own side, or after both threads are done
+    uint64_t producerStalls() const { return producerStalls_; }
+    uint64_t consumerStalls() const { return consumerStalls_; }
+
+private:
+    std::vector<T> slots_;
+    size_t mask_;
+    alignas(64) std::atomic<size_t> head_{0};
+    uint64_t consumerStalls_ = 0;
+    alignas(64) std::atomic<size_t> tail_{0};
+    uint64_t producerStalls_ = 0;
+    alignas(64) std::atomic<bool> closed_{false};
+};
+
+#endif // TYPE_SPSCQUEUE_H_
@@ -0,0 +1,271 @@
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <tuple>
+#include <vector>
+#include "stitchcurves.h"
+#include "meshadjacency.h"
+#include "segmentbvh.h"
+#include "parallel.h"
+#include "profiler.h"
+
+using Real = Geometry::Real;
+using Point = Geometry::Point;
+using BVH = SegmentBVH<3, Real>;
+
+namespace {
+
+// what a boundary vertex is stitched to
+struct Match {
+    enum Kind { NONE, MERGE, SPLIT } kind = NONE;
+    unsigned vertex = 0;    // MERGE: the other vertex
+    uint32_t edge = 0;      // SPLIT: the boundary half-edge to split
+    double t = 0.0;         // SPLIT: where, from origin to target
+    double dist2 = std::numeric_limits<double>::max();
+};
+
+// a vertex inserted into edge j of a triangle
+struct Split {
+    size_t tri;
+    unsigned j;
+    double t;
+    unsigned vertex;
+
+    bool operator<(const Split& s) const {
+        return std::tie(tri, j, t, vertex) <
+            std::tie(s.tri, s.j, s.t, s.vertex);
+    }
+};
+
+double distSqr(const Point& p, const Point& q)
+{
+    double d2 = 0.0;
+    for (unsigned k = 0; k < 3; k++) {
+        d2 += (double(p[k]) - q[k]) * (double(p[k]) - q[k]);
+    }
+    return d2;
+}
+
+double diagonal(const Geometry::VertexStore& verts)
+{
+    if (verts.size() == 0) return 0.0;
+    Point lo = verts[0], hi = verts[0];
+    for (size_t i = 1; i < verts.size(); i++) {
+        for (unsigned k = 0; k < 3; k++) {
+            lo[k] = std::min(lo[k], verts.coord(i, k));
+            hi[k] = std::max(hi[k], verts.coord(i, k));
+        }
+    }
+    return std::sqrt(distSqr(lo, hi));
+}
+
+// triangles from apex to the edge from "from" to "to" with the vertices
+// "inner" inserted in order
+void fan(unsigned apex, unsigned from, const std::vector<unsigned>& inner,
+    unsigned to, std::vector<unsigned>& faces)
+{
+    unsigned a = from;
+    for (unsigned b : inner) {
+        faces.insert(faces.end(), {a, b, apex});
+        a = b;
+    }
+    faces.insert(faces.end(), {a, to, apex});
+}
+
+// Covers triangle c, whose edge j from c[j] to c[j + 1] has the vertices
+// side[j] inserted in order, with a fan from the corner opposite the edge
+// with the most vertices. The end triangles of that fan each have one more
+// side that may be split, and are fanned from the inserted vertex opposite
+// it, so no triangle has its three corners on one edge.
+void triangulateSplit(const unsigned c[3],
+    const std::vector<unsigned> side[3], std::vector<unsigned>& faces)
+{
+    unsigned j = 0;
+    for (unsigned k = 1; k < 3; k++) {
+        if (side[k].size() > side[j].size()) j = k;
+    }
+    const unsigned j1 = (j + 1) % 3, k = (j + 2) % 3;
+    const std::vector<unsigned>& mid = side[j];
+    fan(mid.front(), c[k], side[k], c[j], faces);
+    for (size_t i = 0; i + 1 < mid.size(); i++) {
+        faces.insert(faces.end(), {mid[i], mid[i + 1], c[k]});
+    }
+    fan(mid.back(), c[j1], side[j1], c[k], faces);
+}
+
+} // namespace
+
+void StitchCurves::stitch(Geometry& model)
+{
+    ProfileStage stage("stitch");
+    std::vector<unsigned>& faces = model.faces_;
+    const size_t numOfVerts = model.verts_.size();
+    const double tolerance = (tolerance_ > 0.0) ? tolerance_ :
+        DEFAULT_TOLERANCE * diagonal(model.verts_);
+    const double tol2 = tolerance * tolerance;
+
+    std::vector<unsigned> corners;
+    std::vector<Match> match;
+    {
+        MeshAdjacency adjacency(faces, numOfVerts, threads_);
+        std::vector<BVH::Segment> segments;
+        for (size_t h = 0; h < adjacency.numOfHalfEdges(); h++) {
+            if (adjacency.twin(h) != MeshAdjacency::BOUNDARY) continue;
+            segments.push_back(BVH::Segment{model.verts_[adjacency.origin(h)],
+                model.verts_[adjacency.target(h)], (uint32_t)h});
+            corners.push_back(adjacency.origin(h));
+        }
+        std::sort(corners.begin(), corners.end());
+        corners.erase(std::unique(corners.begin(), corners.end()),
+            corners.end());
+        Profiler::count("stitch.boundary_edges", segments.size());
+        BVH bvh(std::move(segments));
+
+//      Nearest edge end within the tolerance, or else nearest edge; ties go
+//      to the lower vertex or edge number. Edges at the vertex itself don't
+//      count.
+        match.resize(corners.size());
+        unsigned chunks = chunkCount(corners.size(), threads_, 1024);
+        parallelChunks(corners.size(), chunks, [&](unsigned, size_t b,
+            size_t e) {
+            for (size_t i = b; i < e; i++) {
+                const unsigned v = corners[i];
+                const Point p = model.verts_[v];
+                Match& best = match[i];
+                bvh.forEachNear(p, tolerance, [&](const BVH::Segment& s,
+                    double t, double d2) {
+                    unsigned a = adjacency.origin(s.id);
+                    unsigned c = adjacency.target(s.id);
+                    if (a == v || c == v) return;
+                    double da = distSqr(p, s.a), dc = distSqr(p, s.b);
+                    if (da <= tol2 || dc <= tol2) {
+                        unsigned w = (da < dc || (da == dc && a < c)) ? a : c;
+                        double dw = std::min(da, dc);
+                        if (best.kind != Match::MERGE || dw < best.dist2 ||
+                            (dw == best.dist2 && w < best.vertex)) {
+                            best.kind = Match::MERGE;
+                            best.vertex = w;
+                            best.dist2 = dw;
+                        }
+                    } else if (best.kind == Match::NONE ||
+                        (best.kind == Match::SPLIT && (d2 < best.dist2 ||
+                        (d2 == best.dist2 && s.id < best.edge)))) {
+                        best.kind = Match::SPLIT;
+                        best.edge = s.id;
+                        best.t = t;
+                        best.dist2 = d2;
+                    }
+                });
+            }
+        });
+    }
+
+//  merge cracks: every vertex maps to the lowest vertex of its group
+    std::vector<unsigned> root(numOfVerts);
+    for (size_t v = 0; v < numOfVerts; v++) root[v] = v;
+    auto find = [&](unsigned v) {
+        while (root[v] != v) v = root[v] = root[root[v]];
+        return v;
+    };
+    size_t merges = 0;
+    for (size_t i = 0; i < corners.size(); i++) {
+        if (match[i].kind != Match::MERGE) continue;
+        unsigned a = find(corners[i]), b = find(match[i].vertex);
+        if (a == b) continue;
+        root[std::max(a, b)] = std::min(a, b);
+        merges++;
+    }
+    for (size_t v = 0; v < numOfVerts; v++) root[v] = find(v);
+
+//  T-junctions: move the vertex onto the edge and remember the split;
+//  positions come from before any vertex was moved
+    std::vector<Split> splits;
+    std::vector<std::pair<unsigned, Point>> moves;
+    for (size_t i = 0; i < corners.size(); i++) {
+        if (match[i].kind != Match::SPLIT) continue;
+        const uint32_t h = match[i].edge;
+        const size_t tri = h / 3;
+        const unsigned j = h % 3;
+        unsigned v = root[corners[i]];
+        if (v == root[faces[3 * tri]] || v == root[faces[3 * tri + 1]] ||
+            v == root[faces[3 * tri + 2]]) {
+            continue;
+        }
+        Point a = model.verts_[faces[h]];
+        Point b = model.verts_[faces[MeshAdjacency::next(h)]];
+        Point q;
+        for (unsigned k = 0; k < 3; k++) {
+            q[k] = Real(a[k] + match[i].t * (double(b[k]) - a[k]));
+        }
+        moves.emplace_back(v, q);
+        splits.push_back(Split{tri, j, match[i].t, v});
+    }
+    for (const auto& move : moves) model.verts_.set(move.first, move.second);
+    std::sort(splits.begin(), splits.end());
+
+//  rebuild the triangle list in order: collapsed triangles are dropped, and
+//  triangles with split edges are re-triangulated
+    std::vector<unsigned> result;
+    result.reserve(faces.size() + 6 * splits.size());
+    std::vector<unsigned> side[3];
+    size_t collapsed = 0;
+    auto next = splits.begin();
+    for (size_t tri = 0; 3 * tri + 2 < faces.size(); tri++) {
+        unsigned c[3] = {root[faces[3 * tri]], root[faces[3 * tri + 1]],
+            root[faces[3 * tri + 2]]};
+        if (c[0] == c[1] || c[1] == c[2] || c[2] == c[0]) {
+            collapsed++;
+            while (next != splits.end() && next->tri == tri) next++;
+            continue;
+        }
+        if (next == splits.end() || next->tri != tri) {
+            result.insert(result.end(), c, c + 3);
+            continue;
+        }
+        for (unsigned j = 0; j < 3; j++) {
+            side[j].clear();
+            for (; next != splits.end() && next->tri == tri && next->j == j;
+                next++) {
+                side[j].push_back(next->vertex);
+            }
+        }
+        triangulateSplit(c, side, result);
+    }
+    faces.swap(result);
+
+//  drop the vertices that were merged away, keeping the order of the rest
+    if (merges > 0) {
+        std::vector<unsigned> index(numOfVerts);
+        Geometry::VertexStore verts;
+        verts.reserve(numOfVerts - merges);
+        for (size_t v = 0; v < numOfVerts; v++) {
+            if (root[v] != v) continue;
+            index[v] = verts.size();
+            verts.push_back(model.verts_[v]);
+        }
+        for (unsigned& v : faces) v = index[v];
+        model.verts_ = std::move(verts);
+    }
+
+    Profiler::count("stitch.merges", merges);
+    Profiler::count("stitch.splits", splits.size());
+    Profiler::count("stitch.collapsed", collapsed);
+    std::cout << "Stitched " << merges << " cracks and " << splits.size() <<
+        " T-junctions in " << stage.stop() << " seconds!" << std::endl;
+}
@@ -0,0 +1,53 @@
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TYPE_STITCHCURVES_H_
+#define TYPE_STITCHCURVES_H_
+#pragma once
+
+#include <iostream>
+#include "visitor.h"
+#include "geometry.h"
+
+// Closes cracks along the curves where separately tessellated surfaces of
+// a CAD model meet. The boundary edges of the welded mesh go into a
+// SegmentBVH, and every boundary vertex looks for boundary edges of other
+// triangles within the tolerance:
+//  - if it is that close to an end of such an edge, the two vertices are
+//    merged (a crack);
+//  - otherwise it is moved onto the edge, and the triangle of the edge is
+//    split at it (a T-junction).
+// Triangles that collapse are removed. The result doesn't depend on the
+// number of threads.
+class StitchCurves : public Visitor<Geometry> {
+    double tolerance_;
+    unsigned threads_;
+public:
+//  a tolerance of 0 means DEFAULT_TOLERANCE times the diagonal of the
+//  bounding box of the mesh
+    static constexpr double DEFAULT_TOLERANCE = 1.0e-5;
+
+    explicit StitchCurves(double tolerance = 0.0, unsigned threads = 0) :
+        tolerance_(tolerance), threads_(threads) {}
+
+    void dispatch(Geometry& model) override {
+        std::cout << "Stitching curves ..." << std::endl;
+        stitch(model);
+    }
+
+    void stitch(Geometry& model);
+};
+
+#endif // TYPE_STITCHCURVES_H_
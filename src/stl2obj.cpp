@@ -17,12 +17,46 @@
 
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <new>
+#include <stdexcept>
+#include <vector>
 #include <getopt.h>
 
 #include "vectornd.h"
 #include "geometry.h"
 #include "importstl.h"
 #include "exportobj.h"
+#include "exportply.h"
+#include "streamconvert.h"
+#include "pipelineconvert.h"
+#include "profiler.h"
+#include "batchconvert.h"
+#include "convertcache.h"
+#include "meshpasses.h"
+
+//  Allocations are counted for the profile (-P) by replacing the global
+//  operator new of this program. Relaxed atomic increments are cheap next to
+//  malloc itself, so the counting is always on; the array and nothrow forms
+//  of the standard library forward to this one.
+void* operator new(size_t size)
+{
+    Profiler::recordAllocation(size);
+    void* ptr = std::malloc(size ? size : 1);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
 
 // The name of this program
 static const char* PROGRAM_NAME = "stl2obj";
@@ -34,13 +68,53 @@ static const char* AUTHOR = "Amir Baserinia";
 void usage (int status)
 {
     printf ("Usage: %s [OPTION]... [FILE]...\n", PROGRAM_NAME);
-    printf ("Converts CAD STL models to OBJ format.\n");
+    printf ("  or:  %s -b [OPTION]... INPUT OUTPUT [INPUT OUTPUT]...\n",
+        PROGRAM_NAME);
+    printf ("  or:  %s -b [OPTION]... DIRECTORY [OUTPUT_DIRECTORY]\n",
+        PROGRAM_NAME);
+    printf ("  or:  %s -L MANIFEST [OPTION]...\n", PROGRAM_NAME);
+    printf ("Converts CAD STL models to OBJ format, or to binary PLY if the\n"
+        "output file name ends in .ply. Gzip-compressed input is read\n"
+        "as is, and output file names ending in .gz are compressed on -j\n"
+        "threads.\n");
     printf (
         "Options:\n"
         "  -m, --merge-vertices     merge vertices\n"
-        "  -f, --fill-holes         file holes in surface\n"
-        "  -s, --stich-cureves      stick curves between surfaces\n"
-        "  -t, --tolerance          merge tolerance\n");
+        "  -f, --fill-holes         fill holes in surface\n"
+        "  -s, --stich-curves       stitch cracks and T-junctions along\n"
+        "                           curves between surfaces\n"
+        "  -t, --tolerance=TOL      merge corners at most TOL apart (default:\n"
+        "                           1e-8); raise it for scanned data\n"
+        "  -M, --mmap               read binary STL through a memory mapping\n"
+        "  -w, --weld=METHOD        vertex welding method: kdtree (default),\n"
+        "                           grid (hash grid) or sort (multi-threaded)\n"
+        "  -j, --threads=N          number of worker threads (default: all)\n"
+        "  -p, --precision=N        significant digits of vertex coordinates\n"
+        "                           (default: shortest exact representation)\n"
+        "  -B, --memory-budget=SIZE convert out of core with buffers of SIZE\n"
+        "                           bytes (suffixes K, M, G; at least 16M),\n"
+        "                           plus the vertices of a few rows of the\n"
+        "                           mesh; temporary files go to $TMPDIR\n"
+        "  -y, --pipeline           read, weld and write concurrently; the\n"
+        "                           output is the same as with -w kdtree\n"
+        "  -P, --profile=FILE       write per-stage timings, I/O, memory and\n"
+        "                           search tree counters to FILE as JSON\n"
+        "  -b, --batch              convert many files concurrently; -j sets\n"
+        "                           the number of files converted at a time\n"
+        "  -L, --manifest=FILE      batch convert the \"input output\" pairs\n"
+        "                           listed in FILE, one per line\n"
+        "  -X, --max-memory=SIZE    in batch mode, start no conversion that\n"
+        "                           would take the estimated memory in use\n"
+        "                           above SIZE (suffixes K, M, G)\n"
+        "  -C, --cache=DIR          reuse conversions of unchanged input\n"
+        "                           files stored in DIR, and store new ones\n"
+        "                           there\n"
+        "  -O, --optimize           reorder triangles and vertices for the\n"
+        "                           vertex cache of renderers and report the\n"
+        "                           cache misses per triangle (ACMR)\n"
+        "  -Z, --cache-size=SIZE    evict the least recently used entries\n"
+        "                           when the cache grows beyond SIZE\n"
+        "                           (default: 1G)\n");
     printf (
         "Examples:\n"
         "  %s input.stl output.obj  convert input from STL to OBJ and write "
@@ -48,6 +122,50 @@ void usage (int status)
     exit (status);
 }
 
+// parse a size such as "512M" or "16G" (powers of 1024)
+size_t parse_size (const char* str)
+{
+    char* end;
+    double value = strtod (str, &end);
+    switch (*end) {
+    case 'k': case 'K': value *= 1024.0; break;
+    case 'm': case 'M': value *= 1024.0 * 1024.0; break;
+    case 'g': case 'G': value *= 1024.0 * 1024.0 * 1024.0; break;
+    case '\0': break;
+    default: usage (EXIT_FAILURE);
+    }
+    return (size_t)value;
+}
+
+// Convert the files given by a manifest, a directory, or input/output pairs
+// on the command line. Returns the exit status: failure if any file failed.
+int convert_batch (const BatchConvert::Options& options, const char* manifest,
+    int argc, char** argv)
+{
+    std::vector<BatchJob> jobs;
+    if (manifest) {
+        jobs = readManifest (manifest);
+    } else if (argc >= 1 && std::filesystem::is_directory (argv[0])) {
+        jobs = listDirectory (argv[0], (argc > 1) ? argv[1] : "");
+    } else {
+        if (argc == 0 || argc % 2 != 0) usage (EXIT_FAILURE);
+        for (int i = 0; i < argc; i += 2) {
+            jobs.push_back (BatchJob {argv[i], argv[i + 1]});
+        }
+    }
+
+    ProfileStage stage ("batch");
+    std::vector<BatchConvert::Result> results =
+        BatchConvert (options).run (jobs);
+    size_t failures = 0;
+    for (const auto& result : results) failures += !result.ok;
+    Profiler::count ("batch.files", results.size());
+    Profiler::count ("batch.failures", failures);
+    printf ("Converted %zu of %zu files in %g seconds!\n",
+        results.size() - failures, results.size(), stage.stop());
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
 // version information
 void version ()
 {
@@ -62,6 +180,20 @@ int main (int argc, char **argv)
         {"merge-vertices", no_argument, NULL, 'm'},
         {"fill-holes", no_argument, NULL, 'f'},
         {"stich-curves", no_argument, NULL, 's'},
+        {"tolerance", required_argument, NULL, 't'},
+        {"mmap", no_argument, NULL, 'M'},
+        {"weld", required_argument, NULL, 'w'},
+        {"threads", required_argument, NULL, 'j'},
+        {"precision", required_argument, NULL, 'p'},
+        {"memory-budget", required_argument, NULL, 'B'},
+        {"pipeline", no_argument, NULL, 'y'},
+        {"profile", required_argument, NULL, 'P'},
+        {"batch", no_argument, NULL, 'b'},
+        {"manifest", required_argument, NULL, 'L'},
+        {"max-memory", required_argument, NULL, 'X'},
+        {"cache", required_argument, NULL, 'C'},
+        {"cache-size", required_argument, NULL, 'Z'},
+        {"optimize", no_argument, NULL, 'O'},
         {"help", no_argument, NULL, 'h'},
         {"version", no_argument, NULL, 'v'},
         {NULL, 0, NULL, 0}
@@ -69,22 +201,85 @@ int main (int argc, char **argv)
 
 // Variables that are set according to the specified options.
     bool merge_vertices = false;
-    bool fill_holes     = false;
-    bool stich_curves   = false;
-    bool tolerance_val  = false;
+    bool mmap_input     = false;
+    WeldOptions weld;
+    int precision       = 0;
+    size_t memory_budget = 0;
+    bool pipelined      = false;
+    const char* profile_file = NULL;
+    bool batch          = false;
+    const char* manifest_file = NULL;
+    size_t max_memory   = 0;
+    const char* cache_dir = NULL;
+    size_t cache_size   = size_t(1) << 30;
+    MeshPasses passes;
 
 // Parse command line options.
     int c; 
-    while ((c = getopt_long (argc, argv, "mfsvh", long_options, NULL)) != -1) {
+    while ((c = getopt_long (argc, argv, "mfst:Mw:j:p:B:yP:bL:X:C:Z:Ovh",
+        long_options, NULL)) != -1) {
         switch (c) {
         case 'm':
             merge_vertices = true;
             break;
         case 'f':
-            fill_holes = true;
+            passes.fillHoles = true;
             break;
         case 's':
-            stich_curves = true;
+            passes.stitchCurves = true;
+            break;
+        case 't': {
+            char* end;
+            weld.tolerance = strtod (optarg, &end);
+            if (*end != '\0' || !(weld.tolerance >= 0.0)) usage (EXIT_FAILURE);
+            break;
+        }
+        case 'M':
+            mmap_input = true;
+            break;
+        case 'w':
+            if (strcmp (optarg, "kdtree") == 0) {
+                weld.method = WeldMethod::KDTREE;
+            } else if (strcmp (optarg, "grid") == 0) {
+                weld.method = WeldMethod::GRID;
+            } else if (strcmp (optarg, "sort") == 0) {
+                weld.method = WeldMethod::SORT;
+            } else {
+                usage (EXIT_FAILURE);
+            }
+            break;
+        case 'j':
+            weld.threads = atoi (optarg);
+            break;
+        case 'p':
+            precision = atoi (optarg);
+            break;
+        case 'B':
+            memory_budget = parse_size (optarg);
+            break;
+        case 'y':
+            pipelined = true;
+            break;
+        case 'P':
+            profile_file = optarg;
+            break;
+        case 'b':
+            batch = true;
+            break;
+        case 'L':
+            manifest_file = optarg;
+            break;
+        case 'X':
+            max_memory = parse_size (optarg);
+            break;
+        case 'C':
+            cache_dir = optarg;
+            break;
+        case 'Z':
+            cache_size = parse_size (optarg);
+            break;
+        case 'O':
+            passes.optimize = true;
             break;
         case 'v':
             version();
@@ -94,16 +289,110 @@ int main (int argc, char **argv)
         }
     }
 
-//  create a geometry tesselation object
-    Geometry tessel;
+//  out-of-core conversion never holds the whole mesh
+    if (passes.any() && memory_budget > 0) {
+        fprintf (stderr, "%s: --stich-curves, --fill-holes and --optimize "
+            "can't be combined with --memory-budget\n", PROGRAM_NAME);
+        return EXIT_FAILURE;
+    }
+
+//  the pipeline welds with the K-D forest and streams the mesh through
+    if (pipelined && (memory_budget > 0 || passes.any() ||
+        weld.method != WeldMethod::KDTREE)) {
+        fprintf (stderr, "%s: --pipeline can't be combined with "
+            "--memory-budget, mesh passes or --weld=grid/sort\n",
+            PROGRAM_NAME);
+        return EXIT_FAILURE;
+    }
+
+//  stages and counters are only recorded with a profiler installed
+    Profiler profiler;
+    if (profile_file) Profiler::install (&profiler);
+
+//  many files at a time, each of them on a single thread
+    if (batch || manifest_file) {
+        BatchConvert::Options options;
+        options.workers = weld.threads;
+        options.memoryLimit = max_memory;
+        options.mapped = mmap_input;
+        options.weld = weld;
+        options.weld.threads = 1;
+        options.precision = precision;
+        options.memoryBudget = memory_budget;
+        options.pipelined = pipelined;
+        if (cache_dir) options.cacheDir = cache_dir;
+        options.cacheSize = cache_size;
+        options.passes = passes;
+        try {
+            int status = convert_batch (options, manifest_file,
+                argc - optind, argv + optind);
+            if (profile_file) profiler.save (profile_file);
+            return status;
+        } catch (const std::exception& e) {
+            fprintf (stderr, "%s: %s\n", PROGRAM_NAME, e.what());
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (argc - optind < 2) usage (EXIT_FAILURE);
+    const char* input = argv[optind];
+    const char* output = argv[optind + 1];
 
-//  fill up the tesselation object with STL data (load STL)
-    tessel.visit (ImportSTL (argv[optind]));
+    auto convert = [&] {
+//      files larger than memory are converted in bounded-memory passes
+        if (memory_budget > 0) {
+            StreamConvert::Options options;
+            options.memoryBudget = memory_budget;
+            options.tolerance = weld.tolerance;
+            options.precision = precision;
+            options.threads = weld.threads;
+            StreamConvert (options).convert (input, output);
+            return;
+        }
 
-//  write down the tesselation object into OBJ file (save OBJ)
-    tessel.visit (ExportOBJ (argv[optind + 1]));
+//      overlap reading, welding and writing
+        if (pipelined) {
+            PipelineConvert::Options options;
+            options.tolerance = weld.tolerance;
+            options.precision = precision;
+            options.threads = weld.threads;
+            PipelineConvert (options).convert (input, output);
+            return;
+        }
 
+//      create a geometry tesselation object
+        Geometry tessel;
+
+//      fill up the tesselation object with STL data (load STL)
+        tessel.visit (ImportSTL (input, mmap_input, weld));
+
+//      repair and reorder the mesh
+        runMeshPasses (tessel, passes, weld.threads);
+
+//      write down the tesselation object into OBJ file (save OBJ)
+//      the extension of the output file selects the format
+        if (isPLYFile (output)) {
+            tessel.visit (ExportPLY (output, weld.threads));
+        } else {
+            tessel.visit (ExportOBJ (output, precision, weld.threads));
+        }
+    };
+
+    try {
+        if (cache_dir) {
+            ConvertCache cache (cache_dir, cache_size);
+            if (cache.convert (input, cacheTag (weld, precision,
+                memory_budget > 0, passes), output, convert)) {
+                printf ("Reused cached conversion of \"%s\"\n", input);
+            }
+        } else {
+            convert ();
+        }
+        if (profile_file) profiler.save (profile_file);
+    } catch (const std::exception& e) {
+        fprintf (stderr, "%s: %s\n", PROGRAM_NAME, e.what());
+        return EXIT_FAILURE;
+    }
 
     return EXIT_SUCCESS;
 }
-
@@ -0,0 +1,588 @@
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <cmath>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <queue>
+#include <stdexcept>
+#include <vector>
+#include <unistd.h>
+#include "streamconvert.h"
+#include "inputfile.h"
+#include "outputfile.h"
+#include "gzip.h"
+#include "textbuffer.h"
+#include "vectornd.h"
+#include "profiler.h"
+#include "exportply.h"
+
+namespace {
+
+// a corner of the input: its position and its number in file order
+struct CornerRecord {
+    float pos[3];
+    uint64_t corner;
+};
+
+// the vertex that a corner was merged into
+struct IndexRecord {
+    uint64_t corner;
+    uint64_t vertex;
+};
+
+// a sorted run is a range of bytes in a temporary file
+struct Run {
+    uint64_t begin;
+    uint64_t end;
+};
+
+// Anonymous temporary file. It is unlinked right after it is created, so
+// the space is reclaimed when it's closed, even if the process is killed.
+class TempFile {
+    int fd_ = -1;
+    uint64_t size_ = 0;
+public:
+    explicit TempFile(const std::string& dir) {
+        std::string path = dir + "/stl2objXXXXXX";
+        fd_ = ::mkstemp(&path[0]);
+        if (fd_ < 0) {
+            throw std::runtime_error("cannot create a temporary file in \"" +
+                dir + "\": " + std::strerror(errno));
+        }
+        ::unlink(path.c_str());
+    }
+    ~TempFile() { ::close(fd_); }
+    TempFile(const TempFile&) = delete;
+    TempFile& operator=(const TempFile&) = delete;
+
+    uint64_t size() const { return size_; }
+
+//  drop the contents, to write the file again from the start
+    void clear() {
+        if (::ftruncate(fd_, 0) < 0) {
+            throw std::runtime_error(
+                std::string("cannot truncate temporary file: ") +
+                std::strerror(errno));
+        }
+        size_ = 0;
+    }
+
+    void append(const void* data, size_t bytes) {
+        const char* ptr = static_cast<const char*>(data);
+        while (bytes > 0) {
+            ssize_t done = ::pwrite(fd_, ptr, bytes, size_);
+            if (done < 0) {
+                if (errno == EINTR) continue;
+                throw std::runtime_error(
+                    std::string("cannot write temporary file: ") +
+                    std::strerror(errno));
+            }
+            ptr += done;
+            bytes -= done;
+            size_ += done;
+        }
+    }
+
+    void readAt(void* data, size_t bytes, uint64_t offset) const {
+        char* ptr = static_cast<char*>(data);
+        while (bytes > 0) {
+            ssize_t done = ::pread(fd_, ptr, bytes, offset);
+            if (done <= 0) {
+                if (done < 0 && errno == EINTR) continue;
+                throw std::runtime_error("cannot read temporary file");
+            }
+            ptr += done;
+            bytes -= done;
+            offset += done;
+        }
+    }
+};
+
+// buffered sequential reader of the records of one run
+template <typename Record>
+class RunReader {
+    const TempFile* file_;
+    uint64_t pos_;
+    uint64_t end_;
+    std::vector<Record> buffer_;
+    size_t next_ = 0;
+    size_t count_ = 0;
+public:
+    RunReader(const TempFile& file, Run run, size_t bufferRecords) :
+        file_(&file), pos_(run.begin), end_(run.end), buffer_(bufferRecords) {
+        refill();
+    }
+    bool empty() const { return next_ == count_; }
+    const Record& front() const { return buffer_[next_]; }
+    void pop() {
+        if (++next_ == count_) refill();
+    }
+private:
+    void refill() {
+        count_ = std::min<uint64_t>(buffer_.size(),
+            (end_ - pos_) / sizeof(Record));
+        next_ = 0;
+        file_->readAt(buffer_.data(), count_ * sizeof(Record), pos_);
+        pos_ += count_ * sizeof(Record);
+    }
+};
+
+// sort "records" and append them to "file" as a new run
+template <typename Record, typename Less>
+void spill(std::vector<Record>& records, Less less, TempFile& file,
+    std::vector<Run>& runs)
+{
+    if (records.empty()) return;
+    std::sort(records.begin(), records.end(), less);
+    Run run { file.size(), 0 };
+    file.append(records.data(), records.size() * sizeof(Record));
+    run.end = file.size();
+    runs.push_back(run);
+    records.clear();
+}
+
+// records that a run is read in at least, so reads stay sequential
+const size_t MIN_RUN_RECORDS = 4096;
+
+// k-way merge of runs [begin, end) with "perRun" records buffered for each;
+// visit() sees all records in sorted order
+template <typename Record, typename Less, typename Visit>
+void mergeGroup(const TempFile& file, const Run* begin, const Run* end,
+    size_t perRun, Less less, Visit visit)
+{
+    std::vector<RunReader<Record>> readers;
+    readers.reserve(end - begin);
+    for (const Run* run = begin; run != end; ++run) {
+        readers.emplace_back(file, *run, perRun);
+    }
+
+    auto later = [&](size_t a, size_t b) {
+        return less(readers[b].front(), readers[a].front());
+    };
+    std::priority_queue<size_t, std::vector<size_t>, decltype(later)>
+        heap(later);
+    for (size_t r = 0; r < readers.size(); r++) {
+        if (!readers[r].empty()) heap.push(r);
+    }
+    while (!heap.empty()) {
+        size_t r = heap.top();
+        heap.pop();
+        visit(readers[r].front());
+        readers[r].pop();
+        if (!readers[r].empty()) heap.push(r);
+    }
+}
+
+// Merge of sorted runs within "budget" bytes of buffers; visit() sees all
+// records in sorted order. While there are too many runs to give each a
+// buffer of MIN_RUN_RECORDS records, groups of runs are first merged into
+// longer runs in a new temporary file in "tempDir", which replaces the
+// previous one once it's complete.
+template <typename Record, typename Less, typename Visit>
+void mergeRuns(const TempFile& file, std::vector<Run> runs, size_t budget,
+    const std::string& tempDir, Less less, Visit visit)
+{
+//  one buffer more for the output of a group
+    const size_t fanIn = std::max<size_t>(2,
+        budget / sizeof(Record) / MIN_RUN_RECORDS - 1);
+    const size_t perGroupRun = budget / sizeof(Record) / (fanIn + 1);
+    std::unique_ptr<TempFile> level;
+    const TempFile* from = &file;
+    while (runs.size() > fanIn) {
+        std::unique_ptr<TempFile> to (new TempFile(tempDir));
+        std::vector<Run> merged;
+        std::vector<Record> out;
+        out.reserve(perGroupRun);
+        for (size_t g = 0; g < runs.size(); g += fanIn) {
+            const Run* begin = runs.data() + g;
+            const Run* end = runs.data() + std::min(g + fanIn, runs.size());
+            Run run { to->size(), 0 };
+            mergeGroup<Record>(*from, begin, end, perGroupRun, less,
+                [&](const Record& r) {
+                out.push_back(r);
+                if (out.size() == out.capacity()) {
+                    to->append(out.data(), out.size() * sizeof(Record));
+                    out.clear();
+                }
+            });
+            to->append(out.data(), out.size() * sizeof(Record));
+            out.clear();
+            run.end = to->size();
+            merged.push_back(run);
+        }
+        level = std::move(to);
+        from = level.get();
+        runs.swap(merged);
+    }
+    size_t perRun = std::max<size_t>(MIN_RUN_RECORDS,
+        budget / std::max<size_t>(1, runs.size()) / sizeof(Record));
+    mergeGroup<Record>(*from, runs.data(), runs.data() + runs.size(), perRun,
+        less, visit);
+}
+
+// Orders corners by grid cell, then by corner number. With a tolerance of
+// zero, the cells degenerate to exact positions.
+struct CellOrder {
+    double inverse; // 1 / cell size, or 0 for exact positions
+
+    void cellOf(const CornerRecord& r, double cell[3]) const {
+        for (int a = 0; a < 3; a++) {
+            cell[a] = (inverse > 0) ? std::floor(r.pos[a] * inverse) : r.pos[a];
+        }
+    }
+    bool operator()(const CornerRecord& a, const CornerRecord& b) const {
+        double ca[3], cb[3];
+        cellOf(a, ca);
+        cellOf(b, cb);
+        for (int i = 0; i < 3; i++) {
+            if (ca[i] != cb[i]) return ca[i] < cb[i];
+        }
+        return a.corner < b.corner;
+    }
+};
+
+// a corner that became a vertex in the merge pass, and the cell it lies in
+struct RepRecord {
+    double cell[3];
+    CornerRecord record;
+    uint64_t vertex;
+};
+
+// Representatives of the cells that the merge pass has visited and that a
+// later corner may still be merged with. Corners arrive in cell order, so a
+// cell's neighbours that come before it lie in the same slab of cells along
+// x or in the previous one, and in the same row along y or in the rows next
+// to it. Only those rows are kept in memory, in cell order: two of the
+// current slab, and three of the previous one. A slab of more than
+// MIN_RUN_RECORDS representatives is written to a temporary file, from
+// which it is read back row by row while the next slab is visited.
+class RepSweep {
+    const CellOrder& order_;
+    TempFile files_[2];
+    unsigned current_ = 0;  // file that the current slab spills to
+    std::vector<RepRecord> slab_;  // of the current slab, not spilled
+    std::vector<RepRecord> previousSlab_;  // if the previous one didn't spill
+    size_t previousNext_ = 0;
+    std::unique_ptr<RunReader<RepRecord>> previousFile_;  // if it did
+    std::vector<RepRecord> slabRows_;
+    std::vector<RepRecord> previousRows_;
+    double slabX_ = 0;  // x of the cells in the current slab
+    double rowY_ = 0;  // y of the cells in the current row
+    bool started_ = false;
+
+    void spill() {
+        files_[current_].append(slab_.data(), slab_.size() * sizeof(RepRecord));
+        slab_.clear();
+    }
+
+//  next representative of the previous slab that isn't in its rows yet
+    const RepRecord* nextPrevious() const {
+        if (previousFile_) {
+            return previousFile_->empty() ? nullptr : &previousFile_->front();
+        }
+        return previousNext_ < previousSlab_.size() ?
+            &previousSlab_[previousNext_] : nullptr;
+    }
+
+//  drop the rows before y - 1 and take those up to y + 1
+    void advance(double y) {
+        auto before = [&](const RepRecord& rep) { return rep.cell[1] < y - 1; };
+        slabRows_.erase(slabRows_.begin(), std::find_if_not(slabRows_.begin(),
+            slabRows_.end(), before));
+        previousRows_.erase(previousRows_.begin(), std::find_if_not(
+            previousRows_.begin(), previousRows_.end(), before));
+        for (const RepRecord* rep; (rep = nextPrevious()) != nullptr &&
+            rep->cell[1] <= y + 1; ) {
+            if (!before(*rep)) previousRows_.push_back(*rep);
+            if (previousFile_) {
+                previousFile_->pop();
+            } else {
+                previousNext_++;
+            }
+        }
+        rowY_ = y;
+    }
+
+//  start the slab of cells at x
+    void begin(double x) {
+        bool adjacent = started_ && order_.inverse > 0 && x == slabX_ + 1;
+        previousSlab_.clear();
+        previousNext_ = 0;
+        previousFile_.reset();
+        if (adjacent && files_[current_].size() == 0) {
+            previousSlab_.swap(slab_);
+        } else if (adjacent) {
+            spill();
+            const TempFile& file = files_[current_];
+            previousFile_.reset(new RunReader<RepRecord>(file,
+                Run { 0, file.size() }, MIN_RUN_RECORDS));
+            current_ ^= 1;
+        }
+        slab_.clear();
+        if (files_[current_].size() > 0) files_[current_].clear();
+        slabRows_.clear();
+        previousRows_.clear();
+        slabX_ = x;
+    }
+public:
+    RepSweep(const CellOrder& order, const std::string& tempDir) :
+        order_(order), files_{TempFile(tempDir), TempFile(tempDir)} {}
+
+//  The vertex of the representative nearest to "r" among those of its own
+//  cell and of the neighbouring cells visited before it, if that is not
+//  farther than "tolerance"; otherwise -1. Counts as a visit of the cell.
+    int64_t find(const CornerRecord& r, double tolerance) {
+        double cell[3];
+        order_.cellOf(r, cell);
+        bool newSlab = !started_ || cell[0] != slabX_;
+        if (newSlab) begin(cell[0]);
+        if (newSlab || cell[1] != rowY_) advance(cell[1]);
+        started_ = true;
+
+        VectorND<> p(r.pos[0], r.pos[1], r.pos[2]);
+        int64_t best = -1;
+        double minDist = std::numeric_limits<double>::max();
+        auto search = [&](const std::vector<RepRecord>& reps, double y,
+            double z) {
+            auto it = std::lower_bound(reps.begin(), reps.end(),
+                std::make_pair(y, z),
+                [](const RepRecord& a, const std::pair<double, double>& b) {
+                    return a.cell[1] < b.first ||
+                        (a.cell[1] == b.first && a.cell[2] < b.second);
+                });
+            for (; it != reps.end() && it->cell[1] == y && it->cell[2] == z;
+                ++it) {
+                const float* q = it->record.pos;
+                double d = VectorND<>::get_dist_sqr(p,
+                    VectorND<>(q[0], q[1], q[2]));
+                if (d < minDist || (d == minDist && (int64_t)it->vertex <
+                    best)) {
+                    minDist = d;
+                    best = it->vertex;
+                }
+            }
+        };
+        search(slabRows_, cell[1], cell[2]);
+//      exact positions have no neighbours
+        if (order_.inverse > 0) {
+            for (int dy = -1; dy <= 1; dy++) {
+                for (int dz = -1; dz <= 1; dz++) {
+                    search(previousRows_, cell[1] + dy, cell[2] + dz);
+                }
+            }
+            for (int dz = -1; dz <= 1; dz++) {
+                search(slabRows_, cell[1] - 1, cell[2] + dz);
+            }
+            search(slabRows_, cell[1], cell[2] - 1);
+        }
+        if (best >= 0 && minDist <= tolerance * tolerance) return best;
+        return -1;
+    }
+
+//  make "r", the last corner passed to find, a representative
+    void add(const CornerRecord& r, uint64_t vertex) {
+        RepRecord rep;
+        order_.cellOf(r, rep.cell);
+        rep.record = r;
+        rep.vertex = vertex;
+        slabRows_.push_back(rep);
+//      exact positions have no neighbours in the next slab
+        if (order_.inverse == 0) return;
+        slab_.push_back(rep);
+        if (slab_.size() >= MIN_RUN_RECORDS) spill();
+    }
+};
+
+} // namespace
+
+void StreamConvert::convert(const std::string& input, const std::string& output)
+{
+    if (isPLYFile(output)) {
+        throw std::runtime_error("streaming conversion writes OBJ files only");
+    }
+    ProfileStage stage("convert");
+    const size_t budget = std::max<size_t>(options_.memoryBudget, 16 << 20);
+    std::string tempDir = options_.tempDir;
+    if (tempDir.empty()) {
+        const char* env = std::getenv("TMPDIR");
+        tempDir = env ? env : "/tmp";
+    }
+
+//  compressed input is inflated as it is read
+    InputFile fileSTL (input);
+    char header[84];
+    if (fileSTL.read(header, sizeof(header)) < sizeof(header)) {
+        throw std::runtime_error("\"" + input +
+            "\" is too short to be a binary STL file");
+    }
+    uint64_t fileSize = fileSTL.size();
+    uint32_t numOfTris;
+    std::memcpy(&numOfTris, header + 80, sizeof(uint32_t));
+    if (std::memcmp(header, "solid", 5) == 0 &&
+        !fileSTL.mayHaveSize(84 + 50 * (uint64_t)numOfTris)) {
+        throw std::runtime_error("streaming conversion supports binary STL "
+            "files only");
+    }
+//  a short compressed file shows when its records are read
+    if (!fileSTL.compressed() && (fileSize - 84) / 50 < numOfTris) {
+        throw std::runtime_error("\"" + input + "\" is truncated");
+    }
+    std::cout << "Reading " << numOfTris << " triangles ..." << std::endl;
+    Profiler::bytesRead(fileSize);
+
+    const double tolerance = options_.tolerance;
+    CellOrder order { tolerance > 0 ? 1.0 / tolerance : 0.0 };
+
+//  1) sorted runs of corners
+    TempFile cornerFile (tempDir);
+    std::vector<Run> cornerRuns;
+    {
+        ProfileStage pass("sort");
+        std::vector<CornerRecord> records;
+        records.reserve(budget / sizeof(CornerRecord));
+        std::vector<char> block(50 * 4096);
+        uint64_t corner = 0;
+        for (uint32_t done = 0; done < numOfTris; ) {
+            uint32_t count = std::min<uint32_t>(4096, numOfTris - done);
+            if (fileSTL.read(block.data(), 50 * count) < 50 * count) {
+                throw std::runtime_error("\"" + input + "\" is truncated");
+            }
+            for (uint32_t i = 0; i < count; i++) {
+                for (int j = 0; j < 3; j++) {
+                    CornerRecord r;
+                    std::memcpy(r.pos, &block[50 * i + 12 * (j + 1)], 12);
+                    r.corner = corner++;
+                    records.push_back(r);
+                }
+            }
+            done += count;
+            if (records.size() + 3 * 4096 > records.capacity()) {
+                spill(records, order, cornerFile, cornerRuns);
+            }
+        }
+        spill(records, order, cornerFile, cornerRuns);
+    }
+    std::cout << "Sorted corners into " << cornerRuns.size() << " runs" <<
+        std::endl;
+
+    OutputFile file (output);
+    std::unique_ptr<GzipSink> compressed;
+    if (isGzipFile(output)) {
+        compressed.reset(new GzipSink(file, options_.threads));
+    }
+    OutputSink& fileOBJ = compressed ? *compressed : (OutputSink&)file;
+    TextBuffer text (1 << 20);
+    auto flush = [&]() {
+        if (text.size() >= (1 << 20) - 256) {
+            fileOBJ.write(text.data(), text.size());
+            Profiler::bytesWritten(text.size());
+            text.clear();
+        }
+    };
+    text.append("# Object name\n");
+    text.append("o ");
+    text.append(stripGzipSuffix(output).c_str());
+    text.append("\n\n");
+    text.append("# Begin list of vertices\n");
+
+//  2) collapse cells, write vertices, spill (corner, vertex) runs
+    TempFile indexFile (tempDir);
+    std::vector<Run> indexRuns;
+    uint64_t numOfVerts = 0;
+    {
+        ProfileStage pass("merge");
+        auto byCorner = [](const IndexRecord& a, const IndexRecord& b) {
+            return a.corner < b.corner;
+        };
+        std::vector<IndexRecord> pairs;
+        pairs.reserve(budget / 2 / sizeof(IndexRecord));
+
+        RepSweep reps (order, tempDir);
+        mergeRuns<CornerRecord>(cornerFile, cornerRuns, budget / 2, tempDir,
+            order, [&](const CornerRecord& r) {
+            int64_t found = reps.find(r, tolerance);
+            uint64_t vertex;
+            if (found >= 0) {
+                vertex = found;
+            } else {
+                vertex = numOfVerts++;
+                reps.add(r, vertex);
+                text.append("v ");
+                for (int a = 0; a < 3; a++) {
+                    text.appendReal(r.pos[a], options_.precision);
+                    text.append(' ');
+                }
+                text.append("1.0\n");
+                flush();
+            }
+            pairs.push_back(IndexRecord { r.corner, vertex });
+            if (pairs.size() == pairs.capacity()) {
+                spill(pairs, byCorner, indexFile, indexRuns);
+            }
+        });
+        spill(pairs, byCorner, indexFile, indexRuns);
+    }
+    std::cout << "Points reduced from " << 3 * (uint64_t)numOfTris << " to " <<
+        numOfVerts << " after merging!" << std::endl;
+
+    text.append("# End list of vertices\n");
+    text.append("\n");
+    text.append("# Begin list of faces\n");
+
+//  3) faces in file order
+    {
+        ProfileStage pass("faces");
+        uint64_t face[3];
+        uint64_t expected = 0;
+        mergeRuns<IndexRecord>(indexFile, indexRuns, budget, tempDir,
+            [](const IndexRecord& a, const IndexRecord& b) {
+                return a.corner < b.corner;
+            },
+            [&](const IndexRecord& r) {
+            if (r.corner != expected) {
+                throw std::runtime_error("corrupt temporary file");
+            }
+            face[expected++ % 3] = r.vertex;
+            if (expected % 3 == 0) {
+                text.append("f ");
+                for (int j = 0; j < 3; j++) {
+                    text.appendUInt(face[j] + 1);
+                    text.append(' ');
+                }
+                text.append('\n');
+                flush();
+            }
+        });
+    }
+    text.append("# End list of faces\n");
+    text.append("\n");
+    fileOBJ.write(text.data(), text.size());
+    fileOBJ.flush();
+    Profiler::bytesWritten(text.size());
+
+    Profiler::count("weld.corners", 3 * (uint64_t)numOfTris);
+    Profiler::count("weld.vertices", numOfVerts);
+    Profiler::count("weld.merges", 3 * (uint64_t)numOfTris - numOfVerts);
+    Profiler::count("stream.runs", cornerRuns.size() + indexRuns.size());
+    std::cout << "Finished streaming conversion in " << stage.stop() <<
+        " seconds!" << std::endl;
+}
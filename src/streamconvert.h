@@ -0,0 +1,71 @@
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TYPE_STREAMCONVERT_H_
+#define TYPE_STREAMCONVERT_H_
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+//  Bounded-memory conversion of binary STL to OBJ for files larger than RAM.
+//  The conversion runs as three streaming passes over temporary files:
+//  1) Corners are read in blocks that fit the memory budget, sorted by their
+//     cell on a grid of edge "tolerance" (then by corner number), and spilled
+//     to disk as sorted runs.
+//  2) The runs are merged. A corner joins the nearest vertex within the
+//     tolerance in its own cell or in a neighbouring cell that came before
+//     it, so only the vertices of five rows of cells along z are kept; the
+//     rest of the previous slab along x waits in a temporary file. The
+//     vertex of every group is written to the OBJ file as soon as it is
+//     found, and (corner, vertex) pairs are spilled as a second set of runs,
+//     sorted by corner.
+//  3) Those runs are merged by corner, which yields the three vertices of
+//     every triangle in file order, and the faces are written.
+//  Where there are too many runs to merge within the budget, they are first
+//  merged in groups into fewer, longer runs. The budget bounds the buffers
+//  of all passes; the rows of vertices come on top of it, and only grow
+//  with the extent of the mesh along z over the tolerance, not with the
+//  number of triangles.
+//  Vertices are therefore numbered in spatial order rather than in order of
+//  first appearance, so the OBJ file describes the same mesh as the
+//  in-memory converter but lists the vertices in a different order. (Only
+//  where distinct vertices of the mesh lie within the tolerance of each
+//  other can the groups differ, as they depend on the order of merging.)
+class StreamConvert {
+public:
+    struct Options {
+//      upper bound on the memory used for buffers, in bytes
+        size_t memoryBudget = size_t(1) << 30;
+//      corners that are at most this far apart are merged
+        double tolerance = 1.0e-8;
+//      significant digits of vertex coordinates, 0 for the shortest exact
+        int precision = 0;
+//      directory for temporary files; empty means $TMPDIR or /tmp
+        std::string tempDir;
+//      threads that compress .gz output; 0 uses all cores
+        unsigned threads = 0;
+    };
+
+    explicit StreamConvert(const Options& options) : options_(options) {}
+
+//  convert a binary STL file into an OBJ file
+    void convert(const std::string& input, const std::string& output);
+
+private:
+    Options options_;
+};
+
+#endif // TYPE_STREAMCONVERT_H_
@@ -0,0 +1,86 @@
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TYPE_TEXTBUFFER_H_
+#define TYPE_TEXTBUFFER_H_
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Growable byte buffer for formatting text output. Numbers are formatted
+// with std::to_chars, which ignores the locale and doesn't allocate, and the
+// storage is kept between clear() calls so it can be reused for the next
+// block.
+class TextBuffer {
+    std::vector<char> data_;
+    size_t size_ = 0;
+
+//  room for the longest number we ever format
+    static const size_t MAX_NUMBER = 32;
+
+public:
+    explicit TextBuffer(size_t capacity = 0) : data_(capacity) {}
+
+    const char* data() const { return data_.data(); }
+    size_t size() const { return size_; }
+    void clear() { size_ = 0; }
+
+    void append(const char* str, size_t len) {
+        reserve(len);
+        std::memcpy(&data_[size_], str, len);
+        size_ += len;
+    }
+    void append(const char* str) { append(str, std::strlen(str)); }
+    void append(char c) {
+        reserve(1);
+        data_[size_++] = c;
+    }
+
+//  decimal integer
+    void appendUInt(uint64_t value) {
+        reserve(MAX_NUMBER);
+        char* end = std::to_chars(&data_[size_], &data_[size_] + MAX_NUMBER,
+            value).ptr;
+        size_ = end - data_.data();
+    }
+
+//  Floating-point number with "precision" significant digits, like printf's
+//  %g. A precision of 0 gives the shortest string that reads back as the
+//  exact same value. More than 17 digits never adds information.
+    template <typename Real>
+    void appendReal(Real value, int precision = 0) {
+        reserve(MAX_NUMBER);
+        precision = std::min(precision, 17);
+        char* first = &data_[size_];
+        char* end = (precision > 0)
+            ? std::to_chars(first, first + MAX_NUMBER, value,
+                std::chars_format::general, precision).ptr
+            : std::to_chars(first, first + MAX_NUMBER, value).ptr;
+        size_ = end - data_.data();
+    }
+
+private:
+    void reserve(size_t extra) {
+        if (size_ + extra > data_.size()) {
+            data_.resize(std::max(2 * data_.size(), size_ + extra));
+        }
+    }
+};
+
+#endif // TYPE_TEXTBUFFER_H_
@@ -0,0 +1,61 @@
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TYPE_TRIANGLESOUP_H_
+#define TYPE_TRIANGLESOUP_H_
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include "vectornd.h"
+#include "simdkernels.h"
+
+// Read-only view of unwelded triangles as they are stored in memory. Every
+// triangle is a record of "stride" bytes, and its three corners are stored
+// as 9 consecutive single-precision floats at the start of the record. This
+// covers binary STL records (after skipping the normal) as well as plain
+// arrays of floats, without copying either of them.
+//
+// Corner i is vertex (i % 3) of triangle (i / 3).
+class TriangleSoup {
+    const char* base_;
+    size_t stride_;
+    size_t numOfTris_;
+public:
+    TriangleSoup(const char* base, size_t stride, size_t numOfTris) :
+        base_(base), stride_(stride), numOfTris_(numOfTris) {}
+
+//  number of triangles
+    size_t numOfTris() const { return numOfTris_; }
+
+//  number of corners (three per triangle)
+    size_t size() const { return 3 * numOfTris_; }
+
+//  position of corner i; records aren't necessarily aligned
+    template <typename REAL = double>
+    VectorND<3, REAL> corner(size_t i) const {
+        float xyz[3];
+        std::memcpy(xyz, base_ + (i / 3) * stride_ + (i % 3) * sizeof(xyz),
+            sizeof(xyz));
+        return VectorND<3, REAL>(REAL(xyz[0]), REAL(xyz[1]), REAL(xyz[2]));
+    }
+
+//  bounding box of the corners of "count" triangles from "first"
+    void bounds(size_t first, size_t count, float lo[3], float hi[3]) const {
+        recordBounds(base_ + first * stride_, stride_, count, lo, hi);
+    }
+};
+
+#endif // TYPE_TRIANGLESOUP_H_
@@ -84,11 +84,17 @@ public:
 //  element-wise multiplication
     VectorND mult_elems (const VectorND& vec);
 
-//  get distance squared between two points
+//  get distance squared between two points, without a temporary vector;
+//  the sum runs in axis order, exactly as in get_magnit_sqr
     static REAL
     get_dist_sqr(const VectorND<3, REAL>& v1, const VectorND<3, REAL>& v2)
     {
-        return (v1 - v2).get_magnit_sqr();
+        REAL r = 0.0;
+        for (unsigned i = 0; i < 3; ++i) {
+            REAL d = v1.v_[i] - v2.v_[i];
+            r += d * d;
+        }
+        return r;
     }
 
 //  get distance between two points
@@ -0,0 +1,98 @@
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TYPE_VERTEXSTORE_H_
+#define TYPE_VERTEXSTORE_H_
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "vectornd.h"
+
+// Containers for the vertex coordinates of a mesh. Both layouts share the
+// same interface, so code that fills or reads Geometry::verts_ compiles
+// against either of them: vertices are read by value with operator[] and
+// written with push_back or set. Points of any precision are accepted and
+// converted to REAL on the way in.
+
+// array of structures: one VectorND per vertex
+template <typename REAL>
+class AosVertexStore {
+public:
+    using Point = VectorND<3, REAL>;
+
+    size_t size() const { return data_.size(); }
+    void reserve(size_t n) { data_.reserve(n); }
+    void resize(size_t n) { data_.resize(n); }
+    void clear() { data_.clear(); }
+
+    template <typename R>
+    void push_back(const VectorND<3, R>& p) {
+        data_.push_back(Point(REAL(p[0]), REAL(p[1]), REAL(p[2])));
+    }
+
+    template <typename R>
+    void set(size_t i, const VectorND<3, R>& p) {
+        data_[i] = Point(REAL(p[0]), REAL(p[1]), REAL(p[2]));
+    }
+
+    Point operator[](size_t i) const { return data_[i]; }
+
+//  coordinate "axis" of vertex i
+    REAL coord(size_t i, unsigned axis) const { return data_[i][axis]; }
+
+//  all vertices as one contiguous array of x, y, z triples
+    const Point* data() const { return data_.data(); }
+
+private:
+    std::vector<Point> data_;
+};
+
+// structure of arrays: separate x, y and z arrays
+template <typename REAL>
+class SoaVertexStore {
+public:
+    using Point = VectorND<3, REAL>;
+
+    size_t size() const { return xyz_[0].size(); }
+    void reserve(size_t n) { for (auto& v : xyz_) v.reserve(n); }
+    void resize(size_t n) { for (auto& v : xyz_) v.resize(n); }
+    void clear() { for (auto& v : xyz_) v.clear(); }
+
+    template <typename R>
+    void push_back(const VectorND<3, R>& p) {
+        for (unsigned a = 0; a < 3; a++) xyz_[a].push_back(REAL(p[a]));
+    }
+
+    template <typename R>
+    void set(size_t i, const VectorND<3, R>& p) {
+        for (unsigned a = 0; a < 3; a++) xyz_[a][i] = REAL(p[a]);
+    }
+
+    Point operator[](size_t i) const {
+        return Point(xyz_[0][i], xyz_[1][i], xyz_[2][i]);
+    }
+
+//  coordinate "axis" of vertex i
+    REAL coord(size_t i, unsigned axis) const { return xyz_[axis][i]; }
+
+//  contiguous array of one coordinate of all vertices
+    const REAL* axis(unsigned a) const { return xyz_[a].data(); }
+
+private:
+    std::vector<REAL> xyz_[3];
+};
+
+#endif // TYPE_VERTEXSTORE_H_
@@ -0,0 +1,430 @@
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cstdint>
+#include <limits>
+#include <algorithm>
+#include "weld.h"
+#include "hashgrid.h"
+#include "parallel.h"
+#include "radixsort.h"
+#include "profiler.h"
+
+void weld(const TriangleSoup& soup, const WeldOptions& options,
+    Geometry& model)
+{
+    ProfileStage stage("weld");
+    size_t numOfVerts = model.verts_.size();
+    switch (options.method) {
+    case WeldMethod::GRID:
+        weldHashGrid(soup, options.tolerance, model);
+        break;
+    case WeldMethod::SORT:
+        weldSorted(soup, options.tolerance, options.threads, model);
+        break;
+    default:
+        weldKDTree(soup, options.tolerance, model);
+    }
+    numOfVerts = model.verts_.size() - numOfVerts;
+    Profiler::count("weld.corners", soup.size());
+    Profiler::count("weld.vertices", numOfVerts);
+    Profiler::count("weld.merges", soup.size() - numOfVerts);
+}
+
+//  The search structures hold points in the precision of the model, which
+//  halves their memory when the model is single precision.
+using Real = Geometry::Real;
+using Point = Geometry::Point;
+
+// index of the nearest stored vertex if it lies within the tolerance, or -1
+static int findMergeTarget(DynamicKDTree<3, Real>& tree, const Point& vec,
+    double tolerance)
+{
+    int ind = tree.findNearest(vec);
+    if ((ind < 0) || (Point::get_dist_sqr(vec, tree.getPoint(ind)) >
+        tolerance * tolerance)) {
+        return -1;
+    }
+    return ind;
+}
+
+// the hash grid applies the tolerance by itself
+static int findMergeTarget(const HashGrid<3, Real>& grid, const Point& vec,
+    double)
+{
+    return grid.findNearest(vec);
+}
+
+//  Merge "vec" with the nearest vertex seen so far if it lies within the
+//  tolerance, otherwise make it a new vertex; returns the vertex number.
+//  "Index" is any point index with the insert/size/findNearest interface
+//  of KDTree.
+template <typename Index>
+static int mergeOrInsert(Index& index, const Point& vec, double tolerance)
+{
+    int ind = findMergeTarget(index, vec, tolerance);
+    if (ind < 0) {
+        ind = index.size();
+        index.insert(vec);
+    }
+    return ind;
+}
+
+//  weld every corner of the soup in file order
+template <typename Index>
+static void weldIncremental(const TriangleSoup& soup, double tolerance,
+    Index& index, Geometry& model)
+{
+    for (size_t i = 0; i < soup.size(); i++) {
+        auto vec = soup.corner<Real>(i);
+        size_t numOfVerts = index.size();
+        int ind = mergeOrInsert(index, vec, tolerance);
+        if (index.size() > numOfVerts) model.verts_.push_back(vec);
+        model.faces_.push_back(ind);
+    }
+}
+
+unsigned KDTreeWelder::add(const Point& point)
+{
+    return mergeOrInsert(tree_, point, tolerance_);
+}
+
+void KDTreeWelder::profile() const
+{
+//  many visits per query point, or much rebuilding work per insert
+    const auto& stats = tree_.stats();
+    Profiler::count("kdtree.queries", stats.queries);
+    Profiler::count("kdtree.nodes_visited", stats.nodesVisited);
+    Profiler::maximum("kdtree.max_nodes_per_query", stats.maxNodesVisited);
+    Profiler::count("kdtree.inserts", stats.inserts);
+    Profiler::maximum("kdtree.max_depth", stats.maxDepth);
+    Profiler::count("kdtree.rebuilds", stats.rebuilds);
+    Profiler::count("kdtree.rebuilt_points", stats.rebuiltPoints);
+}
+
+void weldKDTree(const TriangleSoup& soup, double tolerance, Geometry& model)
+{
+    KDTreeWelder welder(tolerance);
+    for (size_t i = 0; i < soup.size(); i++) {
+        auto vec = soup.corner<Real>(i);
+        size_t numOfVerts = welder.size();
+        unsigned ind = welder.add(vec);
+        if (welder.size() > numOfVerts) model.verts_.push_back(vec);
+        model.faces_.push_back(ind);
+    }
+    welder.profile();
+}
+
+void weldHashGrid(const TriangleSoup& soup, double tolerance, Geometry& model)
+{
+    HashGrid<3, Real> grid(tolerance);
+    weldIncremental(soup, tolerance, grid, model);
+}
+
+//  Bulk welding in data-parallel steps:
+//  1) Quantize every corner onto a grid whose cells are at least twice as
+//     large as the tolerance, and pack the three 21-bit cell coordinates
+//     into a key.
+//  2) Radix sort (key, corner) pairs. The sort is stable, so corners that
+//     share a cell end up next to each other in ascending corner order.
+//  3) Corners within the tolerance of each other lie in the same or in
+//     adjacent cells. Every run of equal keys looks up the neighbouring
+//     cells that its corners come close enough to, and is linked to those
+//     that hold a corner within the tolerance of one of its own. Linked runs
+//     form clusters, which are independent of each other. Only corners that
+//     would be merged join two cells, so raising the tolerance doesn't chain
+//     the cells of a dense mesh into one cluster that a single thread has
+//     to collapse.
+//  4) Collapse each cluster: walking its corners in corner order, a corner
+//     joins the nearest earlier representative in its own or a linked cell
+//     if it is within the tolerance and becomes a representative otherwise.
+//     This is the decision the K-D tree welder makes when it sees the
+//     corners in file order, so both welders give the same vertices.
+//  5) Representatives are numbered in corner order, which reproduces the
+//     first-appearance numbering of the K-D tree welder.
+void weldSorted(const TriangleSoup& soup, double tolerance, unsigned threads,
+    Geometry& model)
+{
+    const size_t n = soup.size();
+    if (n == 0) return;
+    const unsigned chunks = chunkCount(n, threads);
+    const unsigned BITS = 21;
+    const uint64_t MAXCELL = (uint64_t(1) << BITS) - 1;
+
+//  1) bounding box and cell keys
+    std::vector<VectorND<>> lower(chunks), upper(chunks);
+    parallelChunks(soup.numOfTris(), chunks, [&](unsigned c, size_t begin,
+        size_t end) {
+        float lo[3], hi[3];
+        soup.bounds(begin, end - begin, lo, hi);
+        lower[c] = VectorND<>(double(lo[0]), double(lo[1]), double(lo[2]));
+        upper[c] = VectorND<>(double(hi[0]), double(hi[1]), double(hi[2]));
+    });
+    VectorND<> lo = lower[0], hi = upper[0];
+    for (unsigned c = 1; c < chunks; c++) {
+        for (unsigned a = 0; a < 3; a++) {
+            lo[a] = std::min(lo[a], lower[c][a]);
+            hi[a] = std::max(hi[a], upper[c][a]);
+        }
+    }
+    double extent = std::max(hi[0] - lo[0], std::max(hi[1] - lo[1],
+        hi[2] - lo[2]));
+    double cell = std::max(2.0 * tolerance, extent / MAXCELL);
+    if (!(cell > 0.0)) cell = 1.0;
+
+    std::vector<uint64_t> keys(n);
+    std::vector<uint32_t> order(n);
+    parallelChunks(n, chunks, [&](unsigned, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            auto p = soup.corner(i);
+            uint64_t key = 0;
+            for (unsigned a = 0; a < 3; a++) {
+                uint64_t q = (uint64_t)((p[a] - lo[a]) / cell);
+                key = (key << BITS) | std::min(q, MAXCELL);
+            }
+            keys[i] = key;
+            order[i] = (uint32_t)i;
+        }
+    });
+
+//  2) sort
+    radixSortPairs(keys, order, 3 * BITS, threads);
+
+//  3) runs of equal keys, and the runs of neighbouring cells that each
+//     one's corners come within the tolerance of (with some slack for
+//     rounding)
+    std::vector<size_t> runs(1, 0);
+    std::vector<uint64_t> runKeys(1, keys[0]);
+    for (size_t i = 1; i < n; i++) {
+        if (keys[i] != keys[i - 1]) {
+            runs.push_back(i);
+            runKeys.push_back(keys[i]);
+        }
+    }
+    runs.push_back(n);
+    const size_t numOfRuns = runKeys.size();
+    const double reach = tolerance / cell + 1.0e-6;
+//  whether the corner in sorted position i lies within reach of the side
+//  of its cell at that faces the direction step
+    auto facing = [&](size_t i, const int64_t* at, const int* step) {
+        auto p = soup.corner(order[i]);
+        for (unsigned a = 0; a < 3; a++) {
+            double t = (p[a] - lo[a]) / cell - double(at[a]);
+            if ((step[a] < 0 && t > reach) || (step[a] > 0 && t < 1.0 - reach))
+                return false;
+        }
+        return true;
+    };
+//  whether a corner of run r, in cell at, is within the tolerance of one of
+//  run s in the cell at + step, by the test of step 4; only the corners
+//  near the sides the cells share can be
+    auto near = [&](size_t r, const int64_t* at, size_t s, const int* step) {
+        int64_t there[3];
+        int back[3];
+        for (unsigned a = 0; a < 3; a++) {
+            there[a] = at[a] + step[a];
+            back[a] = -step[a];
+        }
+        std::vector<size_t> across;
+        for (size_t k = runs[s]; k < runs[s + 1]; k++) {
+            if (facing(k, there, back)) across.push_back(k);
+        }
+        for (size_t j = runs[r]; j < runs[r + 1] && !across.empty(); j++) {
+            if (!facing(j, at, step)) continue;
+            auto p = soup.corner<Real>(order[j]);
+            for (size_t k : across) {
+                if (Point::get_dist_sqr(p, soup.corner<Real>(order[k])) <=
+                    tolerance * tolerance) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    };
+
+    const unsigned runChunks = chunkCount(numOfRuns, threads);
+    std::vector<std::vector<std::pair<uint32_t, uint32_t>>>
+        links(runChunks);
+    parallelChunks(numOfRuns, runChunks, [&](unsigned c, size_t begin,
+        size_t end) {
+        for (size_t r = begin; r < end; r++) {
+            int64_t at[3];
+            for (unsigned a = 0; a < 3; a++) {
+                at[a] = (runKeys[r] >> (BITS * (2 - a))) & MAXCELL;
+            }
+            bool below[3] = {false, false, false};
+            bool above[3] = {false, false, false};
+            for (size_t j = runs[r]; j < runs[r + 1]; j++) {
+                auto p = soup.corner(order[j]);
+                for (unsigned a = 0; a < 3; a++) {
+                    double t = (p[a] - lo[a]) / cell - double(at[a]);
+                    below[a] = below[a] || t <= reach;
+                    above[a] = above[a] || t >= 1.0 - reach;
+                }
+            }
+            if (!(below[0] || below[1] || below[2] || above[0] ||
+                above[1] || above[2])) {
+                continue;
+            }
+            for (int d = 0; d < 27; d++) {
+                int step[3] = {d / 9 - 1, d / 3 % 3 - 1, d % 3 - 1};
+                uint64_t key = 0;
+                bool valid = d != 13;
+                for (unsigned a = 0; a < 3 && valid; a++) {
+                    int64_t q = at[a] + step[a];
+                    valid = (step[a] >= 0 || below[a]) &&
+                        (step[a] <= 0 || above[a]) &&
+                        q >= 0 && q <= (int64_t)MAXCELL;
+                    key = (key << BITS) | (uint64_t)q;
+                }
+                if (!valid) continue;
+                auto it = std::lower_bound(runKeys.begin(), runKeys.end(),
+                    key);
+                if (it == runKeys.end() || *it != key) continue;
+                size_t s = it - runKeys.begin();
+                if (near(r, at, s, step)) {
+                    links[c].emplace_back((uint32_t)r, (uint32_t)s);
+                }
+            }
+        }
+    });
+
+//  linked runs of every run; the chunks list them in run order
+    std::vector<size_t> linkStart(numOfRuns + 1, 0);
+    std::vector<uint32_t> linked;
+    for (const auto& list : links) {
+        for (const auto& link : list) {
+            linkStart[link.first + 1]++;
+            linked.push_back(link.second);
+        }
+    }
+    for (size_t r = 0; r < numOfRuns; r++) linkStart[r + 1] += linkStart[r];
+
+//  clusters of linked runs, through union-find
+    std::vector<uint32_t> parent(numOfRuns);
+    for (size_t r = 0; r < numOfRuns; r++) parent[r] = (uint32_t)r;
+    auto root = [&](uint32_t r) {
+        while (parent[r] != r) r = parent[r] = parent[parent[r]];
+        return r;
+    };
+    for (const auto& list : links) {
+        for (const auto& link : list) {
+            uint32_t a = root(link.first), b = root(link.second);
+            if (a != b) parent[std::max(a, b)] = std::min(a, b);
+        }
+    }
+//  the runs of every cluster, in run order; "slot" is a run's position
+//  within its cluster
+    std::vector<uint32_t> cluster(numOfRuns), slot(numOfRuns);
+    std::vector<size_t> clusterStart(1, 0);
+    for (size_t r = 0; r < numOfRuns; r++) {
+        uint32_t head = root((uint32_t)r);
+        if (head == r) {
+            cluster[r] = (uint32_t)(clusterStart.size() - 1);
+            clusterStart.push_back(0);
+        } else {
+            cluster[r] = cluster[head];
+        }
+        slot[r] = (uint32_t)clusterStart[cluster[r] + 1]++;
+    }
+    const size_t numOfClusters = clusterStart.size() - 1;
+    for (size_t c = 0; c < numOfClusters; c++) {
+        clusterStart[c + 1] += clusterStart[c];
+    }
+    std::vector<uint32_t> members(numOfRuns);
+    for (size_t r = 0; r < numOfRuns; r++) {
+        members[clusterStart[cluster[r]] + slot[r]] = (uint32_t)r;
+    }
+
+//  4) collapse clusters
+    std::vector<uint32_t> rep(n);
+    const unsigned clusterChunks = chunkCount(numOfClusters, threads);
+    parallelChunks(numOfClusters, clusterChunks, [&](unsigned, size_t begin,
+        size_t end) {
+        std::vector<std::pair<uint32_t, uint32_t>> corners; // corner, run
+        std::vector<std::vector<uint32_t>> reps;            // by slot
+        for (size_t c = begin; c < end; c++) {
+            corners.clear();
+            size_t size = clusterStart[c + 1] - clusterStart[c];
+            for (size_t m = clusterStart[c]; m < clusterStart[c + 1]; m++) {
+                uint32_t r = members[m];
+                for (size_t j = runs[r]; j < runs[r + 1]; j++) {
+                    corners.emplace_back(order[j], r);
+                }
+            }
+//          a single run is in corner order already
+            if (size > 1) std::sort(corners.begin(), corners.end());
+            if (reps.size() < size) reps.resize(size);
+            for (size_t k = 0; k < size; k++) reps[k].clear();
+
+            for (const auto& corner : corners) {
+                uint32_t id = corner.first, r = corner.second;
+                auto p = soup.corner<Real>(id);
+                int best = -1;
+                Real minDist = std::numeric_limits<Real>::max();
+//              distances and ties as in DynamicKDTree::findNearest
+                auto search = [&](uint32_t s) {
+                    for (uint32_t q : reps[slot[s]]) {
+                        Real d = Point::get_dist_sqr(p, soup.corner<Real>(q));
+                        if (d < minDist || (d == minDist && (int)q < best)) {
+                            minDist = d;
+                            best = q;
+                        }
+                    }
+                };
+                search(r);
+                for (size_t e = linkStart[r]; e < linkStart[r + 1]; e++) {
+                    search(linked[e]);
+                }
+                if ((best < 0) || (minDist > tolerance * tolerance)) {
+                    reps[slot[r]].push_back(id);
+                    rep[id] = id;
+                } else {
+                    rep[id] = best;
+                }
+            }
+        }
+    });
+
+//  5) number representatives in corner order; the representative of a
+//     corner never comes after it, so its number is known by then
+    std::vector<size_t> offset(chunks + 1, 0);
+    parallelChunks(n, chunks, [&](unsigned c, size_t begin, size_t end) {
+        size_t count = 0;
+        for (size_t i = begin; i < end; i++) count += (rep[i] == i);
+        offset[c + 1] = count;
+    });
+    for (unsigned c = 0; c < chunks; c++) offset[c + 1] += offset[c];
+
+    size_t base = model.verts_.size();
+    model.verts_.resize(base + offset[chunks]);
+    size_t first = model.faces_.size();
+    model.faces_.resize(first + n);
+    unsigned* faces = &model.faces_[first];
+    parallelChunks(n, chunks, [&](unsigned c, size_t begin, size_t end) {
+        size_t next = base + offset[c];
+        for (size_t i = begin; i < end; i++) {
+            if (rep[i] == i) {
+                model.verts_.set(next, soup.corner(i));
+                faces[i] = (unsigned)next++;
+            }
+        }
+    });
+    parallelChunks(n, chunks, [&](unsigned, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            if (rep[i] != i) faces[i] = faces[rep[i]];
+        }
+    });
+}
@@ -0,0 +1,75 @@
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TYPE_WELD_H_
+#define TYPE_WELD_H_
+#pragma once
+
+#include "geometry.h"
+#include "trianglesoup.h"
+#include "dynamickdtree.h"
+
+// Welding turns a triangle soup into an indexed mesh: corners closer than
+// the tolerance share one vertex. Every method numbers the vertices in the
+// order in which they first appear in the soup.
+enum class WeldMethod {
+    KDTREE, // one nearest-point query per corner against a growing forest
+            // of balanced K-D trees (DynamicKDTree)
+    SORT,   // bulk, multi-threaded: radix sort quantized corners
+    GRID    // one exact-bit hash probe per corner, neighbour cells on a miss
+};
+
+struct WeldOptions {
+    WeldMethod method = WeldMethod::KDTREE;
+//  corners that are at most this far apart are merged
+    double tolerance = 1.0e-8;
+//  number of worker threads for parallel methods; 0 uses all cores
+    unsigned threads = 0;
+};
+
+// fill model.verts_ and model.faces_ from the soup
+void weld(const TriangleSoup& soup, const WeldOptions& options,
+    Geometry& model);
+
+void weldKDTree(const TriangleSoup& soup, double tolerance, Geometry& model);
+void weldHashGrid(const TriangleSoup& soup, double tolerance, Geometry& model);
+void weldSorted(const TriangleSoup& soup, double tolerance, unsigned threads,
+    Geometry& model);
+
+// weldKDTree one corner at a time, for corners that arrive as a stream
+class KDTreeWelder {
+public:
+    explicit KDTreeWelder(double tolerance) : tolerance_(tolerance) {}
+
+    KDTreeWelder(const KDTreeWelder&) = delete;
+    KDTreeWelder& operator=(const KDTreeWelder&) = delete;
+
+//  Number of the vertex that "point" is merged into: the nearest earlier
+//  vertex if it lies within the tolerance, or else a new one, which is
+//  then the last, size() - 1.
+    unsigned add(const Geometry::Point& point);
+
+//  number of vertices so far
+    size_t size() const { return tree_.size(); }
+
+//  add the counters of the search tree to the current profile
+    void profile() const;
+
+private:
+    DynamicKDTree<3, Geometry::Real> tree_;
+    double tolerance_;
+};
+
+#endif // TYPE_WELD_H_
@@ -0,0 +1,61 @@
+// stl2obj converts an STL CAD file to OBJ format.
+
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <cassert>
+#include "../src/asciistl.h"
+
+// Unit test
+int main()
+{
+    std::string facet =
+        "  facet normal 0 0 1\n"
+        "    outer loop\n"
+        "      vertex 0 0 0\n"
+        "      vertex +1.5e+00 0 -2\n"
+        "      vertex 0 1 0.25\n"
+        "    endloop\n"
+        "  endfacet\n";
+
+//  the name of the solid must not be taken for a keyword
+    std::string text = "solid vertex 1 2\n";
+    for (int i = 0; i < 100000; i++) text += facet;
+    text += "endsolid vertex\n";
+    assert(isAsciiSTL(text.data(), text.size()));
+
+//  a binary file whose header happens to start with "solid"
+    std::string binary(84, ' ');
+    binary.replace(0, 5, "solid");
+    binary[80] = binary[81] = binary[82] = binary[83] = 0;
+    assert(!isAsciiSTL(binary.data(), binary.size()));
+
+//  the result must not depend on how the text is split into chunks
+    for (unsigned threads : {1, 4, 16}) {
+        std::vector<float> coords = parseAsciiSTL(text.data(), text.size(),
+            threads);
+        assert(coords.size() == 9 * 100000);
+        for (size_t i = 0; i < coords.size(); i += 9) {
+            assert(coords[i + 3] == 1.5f);
+            assert(coords[i + 5] == -2.0f);
+            assert(coords[i + 8] == 0.25f);
+        }
+    }
+
+    printf("Terminated successfully!\n");
+}
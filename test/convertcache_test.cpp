@@ -0,0 +1,144 @@
+// stl2obj converts an STL CAD file to OBJ format.
+
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cassert>
+#include "../src/convertcache.h"
+
+namespace fs = std::filesystem;
+
+static void writeFile(const std::string& name, const std::string& text)
+{
+    std::ofstream file(name, std::ios::binary);
+    file << text;
+}
+
+static std::string readFile(const std::string& name)
+{
+    std::ifstream file(name, std::ios::binary);
+    std::ostringstream text;
+    text << file.rdbuf();
+    return text.str();
+}
+
+// what converting "input" into "output" writes
+static std::string converted(const std::string& input,
+    const std::string& output)
+{
+    return "# Object name\no " + output + "\n\nv " + readFile(input) + "\n";
+}
+
+// path of the cache entry for "key" of an OBJ file
+static std::string entryPath(const std::string& dir, uint64_t key)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.obj", (unsigned long long)key);
+    return dir + "/" + name;
+}
+
+// Unit test
+int main()
+{
+    const char* tmp = std::getenv("TMPDIR");
+    std::string base = std::string(tmp ? tmp : "/tmp") + "/convertcache_test";
+    std::string dir = base + "/cache";
+    fs::remove_all(base);
+    fs::create_directories(base);
+    std::string input = base + "/a.stl", output = base + "/a.obj";
+    writeFile(input, "1 2 3");
+
+    ConvertCache cache(dir, 1 << 20);
+    unsigned conversions = 0;
+    auto convert = [&](const std::string& in, const std::string& out) {
+        return [&, in, out]() {
+            conversions++;
+            writeFile(out, converted(in, out));
+        };
+    };
+
+//  a miss converts and stores the output through a temporary file, which
+//  is renamed into place, so only the entry is left
+    assert(!cache.convert(input, "tag", output, convert(input, output)));
+    assert(conversions == 1);
+    std::string entry = entryPath(dir, cache.key(input, "tag", output));
+    assert(fs::exists(entry));
+    unsigned files = 0;
+    for (const auto& item : fs::directory_iterator(dir)) {
+        assert(item.path() == entry);
+        files++;
+    }
+    assert(files == 1);
+
+//  a hit copies the entry, with the object name of the new output
+    std::string other = base + "/b.obj";
+    assert(cache.convert(input, "tag", other, convert(input, other)));
+    assert(conversions == 1);
+    assert(readFile(other) == converted(input, other));
+
+//  other options or other input content are misses
+    assert(!cache.convert(input, "tag2", other, convert(input, other)));
+    assert(conversions == 2);
+    writeFile(input, "4 5 6");
+    assert(!cache.convert(input, "tag", other, convert(input, other)));
+    assert(conversions == 3);
+    assert(cache.key(input, "tag", other) !=
+        cache.key(input, "tag2", other));
+
+//  Least recently used entries are evicted by modification time, which a
+//  hit refreshes; temporary files are removed once they are stale, and
+//  other files are left alone.
+    fs::remove_all(dir);
+    const uint64_t size = converted(input, output).size();
+    ConvertCache small(dir, 2 * size + size / 2);
+    std::string inputs[3];
+    for (int i = 0; i < 3; i++) {
+        inputs[i] = base + "/" + std::to_string(i) + ".stl";
+        writeFile(inputs[i], "7 8 " + std::to_string(i));
+    }
+    auto path = [&](int i) { return entryPath(dir, small.key(inputs[i],
+        "tag", output)); };
+    assert(!small.convert(inputs[0], "tag", output,
+        convert(inputs[0], output)));
+    assert(!small.convert(inputs[1], "tag", output,
+        convert(inputs[1], output)));
+    const auto now = fs::file_time_type::clock::now();
+    fs::last_write_time(path(0), now - std::chrono::hours(3));
+    fs::last_write_time(path(1), now - std::chrono::hours(2));
+    writeFile(dir + "/.tmp-stale", "x");
+    fs::last_write_time(dir + "/.tmp-stale", now - std::chrono::hours(2));
+    writeFile(dir + "/.tmp-fresh", "x");
+    writeFile(dir + "/notes.txt", std::string(4 * size, 'x'));
+
+    assert(small.convert(inputs[0], "tag", output,
+        convert(inputs[0], output)));
+    assert(!small.convert(inputs[2], "tag", output,
+        convert(inputs[2], output)));
+    assert(fs::exists(path(0)) && !fs::exists(path(1)) &&
+        fs::exists(path(2)));
+    assert(!fs::exists(dir + "/.tmp-stale"));
+    assert(fs::exists(dir + "/.tmp-fresh"));
+    assert(fs::exists(dir + "/notes.txt"));
+
+    fs::remove_all(base);
+    printf("Terminated successfully!\n");
+}
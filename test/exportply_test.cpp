@@ -0,0 +1,105 @@
+// stl2obj converts an STL CAD file to OBJ format.
+
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cassert>
+#include "../src/exportply.h"
+#include "../src/inputfile.h"
+
+// Unit test
+int main()
+{
+    assert(isPLYFile("a.ply") && isPLYFile("a.PLY.gz"));
+    assert(!isPLYFile("a.obj") && !isPLYFile("ply"));
+
+//  a strip of 100000 triangles, more than one block of faces
+    const unsigned N = 50000;
+    Geometry model;
+    for (unsigned i = 0; i <= N; i++) {
+        model.verts_.push_back(VectorND<3, double>(0.1 * i, 0.0, 1.0 / 3));
+        model.verts_.push_back(VectorND<3, double>(0.1 * i, 1.0, -1.0 / 3));
+    }
+    for (unsigned i = 0; i < N; i++) {
+        model.faces_.insert(model.faces_.end(), {2 * i, 2 * i + 2,
+            2 * i + 1,  2 * i + 1, 2 * i + 2, 2 * i + 3});
+    }
+
+    const char* dir = std::getenv("TMPDIR");
+    std::string base = std::string(dir ? dir : "/tmp") + "/exportply_test";
+    for (std::string name : {base + ".ply", base + ".ply.gz"}) {
+        ExportPLY(name, 2).save(model);
+        InputFile file (name);
+        assert(file.compressed() == (name.back() == 'z'));
+        std::vector<char> data;
+        file.readAll(data);
+        std::remove(name.c_str());
+
+//      the header declares the precision of the model and the counts
+        const std::string END = "end_header\n";
+        std::string text(data.data(), std::min<size_t>(data.size(), 1024));
+        size_t end = text.find(END);
+        assert(end != std::string::npos);
+        std::istringstream header(text.substr(0, end));
+        const char* type = (sizeof(Geometry::Real) == sizeof(float)) ?
+            "float" : "double";
+        std::vector<std::string> expected = {
+            "ply",
+            "format binary_little_endian 1.0",
+            "comment generated by stl2obj",
+            "element vertex " + std::to_string(2 * (N + 1)),
+            std::string("property ") + type + " x",
+            std::string("property ") + type + " y",
+            std::string("property ") + type + " z",
+            "element face " + std::to_string(2 * N),
+            "property list uchar uint vertex_indices"};
+        for (const std::string& line : expected) {
+            std::string read;
+            assert(std::getline(header, read) && read == line);
+        }
+
+//      the body holds exactly the vertices and faces of the model
+        const char* body = data.data() + end + END.size();
+        const size_t VERTEX = 3 * sizeof(Geometry::Real);
+        const size_t FACE = 1 + 3 * sizeof(uint32_t);
+        assert(data.size() == size_t(body - data.data()) +
+            model.verts_.size() * VERTEX + model.faces_.size() / 3 * FACE);
+        for (size_t v = 0; v < model.verts_.size(); v++) {
+            Geometry::Real xyz[3];
+            std::memcpy(xyz, body + v * VERTEX, VERTEX);
+            Geometry::Point p = model.verts_[v];
+            for (unsigned a = 0; a < 3; a++) assert(xyz[a] == p[a]);
+        }
+        body += model.verts_.size() * VERTEX;
+        for (size_t f = 0; f < model.faces_.size(); f += 3) {
+            assert(body[0] == 3);
+            uint32_t index[3];
+            std::memcpy(index, body + 1, sizeof(index));
+            for (unsigned j = 0; j < 3; j++) {
+                assert(index[j] == model.faces_[f + j]);
+            }
+            body += FACE;
+        }
+    }
+
+    printf("Terminated successfully!\n");
+}
@@ -0,0 +1,99 @@
+// stl2obj converts an STL CAD file to OBJ format.
+
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cassert>
+#include "../src/gzip.h"
+
+// compress "data" in pieces of "piece" bytes on "threads" threads
+static std::vector<char> compress(const std::vector<char>& data,
+    unsigned threads, size_t piece)
+{
+    std::vector<char> out;
+    BufferSink buffer(out);
+    GzipSink sink(buffer, threads);
+    for (size_t i = 0; i < data.size(); i += piece) {
+        sink.write(data.data() + i, std::min(piece, data.size() - i));
+    }
+    sink.flush();
+    assert(sink.size() == data.size());
+    assert(sink.compressedSize() == out.size());
+    return out;
+}
+
+// Unit test
+int main()
+{
+//  OBJ-like text over many blocks and rounds
+    std::default_random_engine gen(0);
+    std::uniform_int_distribution<int> dis(0, 99999);
+    std::string text;
+    while (text.size() < 5 * 1000 * 1000) {
+        text += "v " + std::to_string(dis(gen)) + " " +
+            std::to_string(dis(gen)) + " 0.5 1.0\n";
+    }
+    std::vector<char> data(text.begin(), text.end());
+
+//  the output round-trips and doesn't depend on threads or write sizes
+    std::vector<char> one = compress(data, 1, 1 << 20);
+    assert(isGzip(one.data(), one.size()));
+    assert(one.size() < data.size() / 2);
+    assert(compress(data, 3, 1 << 20) == one);
+    assert(compress(data, 4, 77777) == one);
+    std::vector<char> back;
+    gunzip(one.data(), one.size(), back);
+    assert(back == data);
+
+//  empty input is a valid gzip file
+    std::vector<char> empty = compress(std::vector<char>(), 2, 1);
+    gunzip(empty.data(), empty.size(), back);
+    assert(back.empty());
+
+//  concatenated members inflate one after the other
+    std::vector<char> small(data.begin(), data.begin() + 1000);
+    std::vector<char> two = compress(small, 1, 1000);
+    two.insert(two.end(), one.begin(), one.end());
+    gunzip(two.data(), two.size(), back);
+    assert(back.size() == small.size() + data.size());
+    assert(std::equal(data.begin(), data.end(), back.begin() + 1000));
+
+//  truncated or corrupt data is an error
+    bool thrown = false;
+    try {
+        gunzip(one.data(), one.size() / 2, back);
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    assert(thrown);
+    thrown = false;
+    one[one.size() / 2] ^= 0x55;
+    try {
+        gunzip(one.data(), one.size(), back);
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    assert(thrown);
+
+    assert(isGzipFile("a.obj.GZ") && !isGzipFile("a.obj"));
+    assert(stripGzipSuffix("a.stl.gz") == "a.stl");
+
+    printf("Terminated successfully!\n");
+}
@@ -0,0 +1,44 @@
+// stl2obj converts an STL CAD file to OBJ format.
+
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <cassert>
+#include "../src/hash64.h"
+
+// Unit test
+int main()
+{
+//  reference values of XXH64
+    assert(hash64("", 0) == 0xEF46DB3751D8E999ULL);
+    assert(hash64("a", 1) == 0xD24EC4F1A98C6E5BULL);
+    std::string text = "Nobody inspects the spammish repetition";
+    assert(hash64(text.data(), text.size()) == 0xFBCEA83C8A378BF1ULL);
+
+//  every byte and the seed matter, at any alignment
+    std::vector<char> data(1000, 'x');
+    uint64_t h = hash64(data.data() + 1, 999);
+    for (size_t i = 1; i < data.size(); i += 37) {
+        data[i] ^= 1;
+        assert(hash64(data.data() + 1, 999) != h);
+        data[i] ^= 1;
+    }
+    assert(hash64(data.data() + 1, 999, 1) != h);
+
+    printf("Terminated successfully!\n");
+}
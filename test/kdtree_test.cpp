@@ -21,8 +21,11 @@
 #include <random>
 #include <chrono>
 #include <cassert>
+#include <vector>
+#include <algorithm>
 #include "../src/vectornd.h"
 #include "../src/kdtree.h"
+#include "../src/dynamickdtree.h"
 
 // Unit test
 int main()
@@ -72,6 +75,93 @@ int main()
 
     printf("Brute force time: %.6g sec\n", delt1.count());
     printf("KD tree time:     %.6g sec\n", delt2.count());
+
+//  points on a regular grid in sorted order; inserting them one by one
+//  would degenerate the tree into a list, but the bulk build is balanced
+    std::vector<VectorND<>> grid;
+    for (int i = 0; i < 100; i++)
+        for (int j = 0; j < 100; j++)
+            for (int k = 0; k < 100; k++)
+                grid.push_back(VectorND<>(0.01 * i, 0.01 * j, 0.01 * k));
+    KDTree<3> balanced(grid, 4);
+    assert(balanced.size() == grid.size());
+    assert(balanced.depth() <= 20);
+
+//  renumbering the nodes must not change the tree
+    balanced.layoutBreadthFirst();
+    assert(balanced.depth() <= 20);
+
+    std::vector<VectorND<>> centers;
+    for (int i = 0; i < 1000; i++) {
+        VectorND<> center (dis(gen), dis(gen), dis(gen));
+        int index1 = balanced.findNearestBruteForce(center);
+        int index2 = balanced.findNearest(center);
+        assert(VectorND<>::get_dist_sqr(center, balanced.getPoint(index1)) ==
+            VectorND<>::get_dist_sqr(center, balanced.getPoint(index2)));
+        centers.push_back(center);
+    }
+
+//  batched queries break ties towards the lower index, exactly like the
+//  brute force search; grid points (many equidistant) are a good test
+    for (int i = 0; i < 1000; i++) centers.push_back(grid[i * 997]);
+    std::vector<int> batch(centers.size());
+    balanced.findNearestBatch(centers.data(), centers.size(), batch.data(), 3);
+    for (size_t i = 0; i < centers.size(); i++) {
+        assert(batch[i] == balanced.findNearestBruteForce(centers[i]));
+    }
+//  radius and k-nearest queries agree with a brute force scan, on the
+//  incremental tree and on the bulk-built one
+    std::vector<int> found;
+    for (int i = 0; i < 200; i++) {
+        VectorND<> center (dis(gen), dis(gen), dis(gen));
+        double radius = 0.02 + 0.03 * dis(gen);
+        std::vector<int> expected;
+        for (size_t j = 0; j < tree.size(); j++) {
+            if (VectorND<>::get_dist_sqr(center, tree.getPoint(j)) <=
+                radius * radius) {
+                expected.push_back(j);
+            }
+        }
+        tree.findWithinRadius(center, radius, found);
+        assert(found == expected);
+
+        std::vector<std::pair<double, int>> nearest;
+        for (size_t j = 0; j < grid.size(); j++) {
+            nearest.emplace_back(
+                VectorND<>::get_dist_sqr(grid[i * 4999], grid[j]), j);
+        }
+        std::sort(nearest.begin(), nearest.end());
+        balanced.findKNearest(grid[i * 4999], 7, found);
+        assert(found.size() == 7);
+        for (size_t j = 0; j < found.size(); j++) {
+            assert(found[j] == nearest[j].second);
+        }
+    }
+    balanced.findKNearest(grid[0], 0, found);
+    assert(found.empty());
+
+//  the dynamic tree stays shallow on sorted insertions, and finds the same
+//  nearest points as a brute force search while it grows
+    DynamicKDTree<3> dynamic;
+    for (size_t i = 0; i < grid.size(); i++) {
+        dynamic.insert(grid[i]);
+        if (i % 9973 == 0) {
+            VectorND<> center (dis(gen), dis(gen), dis(gen));
+            int index = dynamic.findNearest(center);
+            double best = VectorND<>::get_dist_sqr(center,
+                dynamic.getPoint(index));
+            for (size_t j = 0; j <= i; j++) {
+                double d = VectorND<>::get_dist_sqr(center, grid[j]);
+                assert(d > best || (d == best && (int)j >= index));
+            }
+        }
+    }
+    assert(dynamic.stats().maxDepth <= 20);
+    assert(dynamic.numOfTrees() <= 20);
+    for (size_t i = 0; i < 1000; i++) {
+        assert(dynamic.findNearest(grid[i * 997]) == (int)(i * 997));
+    }
+
     printf("Terminated successfully!\n", delt2.count());
 }
 
@@ -0,0 +1,114 @@
+// stl2obj converts an STL CAD file to OBJ format.
+
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cassert>
+#include "../src/memoryconvert.h"
+#include "../src/gzip.h"
+
+// counts the bytes written to it
+class CountingSink : public OutputSink {
+public:
+    size_t bytes = 0;
+    void write(const char*, size_t size) override { bytes += size; }
+};
+
+// binary STL of "n" triangles, each with its own three corners
+static std::vector<char> makeSTL(uint32_t n, const float* corners)
+{
+    std::vector<char> stl(84 + 50 * n, 0);
+    std::memcpy(&stl[80], &n, 4);
+    for (uint32_t t = 0; t < n; t++) {
+        std::memcpy(&stl[84 + 50 * t + 12], corners + 9 * t, 36);
+    }
+    return stl;
+}
+
+// Unit test
+int main()
+{
+//  two triangles of a unit square share an edge
+    const float square[] = {
+        0, 0, 0,  1, 0, 0,  1, 1, 0,
+        0, 0, 0,  1, 1, 0,  0, 1, 0
+    };
+    std::vector<char> stl = makeSTL(2, square);
+
+    MemoryConvert::Options options;
+    options.objectName = "square";
+    MemoryConvert convert(options);
+    std::vector<char> obj;
+    convert.convert(stl.data(), stl.size(), obj);
+    assert(convert.numOfVerts() == 4);
+    assert(convert.numOfTris() == 2);
+    std::string text(obj.begin(), obj.end());
+    assert(text.find("o square\n") != std::string::npos);
+    assert(text.find("v 0 1 0 1.0\n") != std::string::npos);
+    assert(text.find("f 1 3 4 \n") != std::string::npos);
+
+//  the same object converts again into the same bytes, and appends
+    convert.convert(stl.data(), stl.size(), obj);
+    assert(obj.size() == 2 * text.size());
+    assert(std::string(obj.begin() + text.size(), obj.end()) == text);
+
+//  ASCII input and a caller-defined sink
+    std::string ascii = "solid square\n";
+    for (int t = 0; t < 2; t++) {
+        ascii += "facet normal 0 0 1\nouter loop\n";
+        for (int c = 0; c < 3; c++) {
+            char line[64];
+            snprintf(line, sizeof(line), "vertex %g %g %g\n",
+                square[9 * t + 3 * c], square[9 * t + 3 * c + 1],
+                square[9 * t + 3 * c + 2]);
+            ascii += line;
+        }
+        ascii += "endloop\nendfacet\n";
+    }
+    ascii += "endsolid square\n";
+    CountingSink sink;
+    convert.convert(ascii.data(), ascii.size(), sink);
+    assert(sink.bytes == text.size());
+
+//  compressed input, and compressed output through a GzipSink
+    std::vector<char> packed;
+    BufferSink packedSink(packed);
+    GzipSink compressor(packedSink, 1);
+    compressor.write(stl.data(), stl.size());
+    compressor.flush();
+    std::vector<char> objz;
+    BufferSink objzSink(objz);
+    GzipSink objCompressor(objzSink, 1);
+    convert.convert(packed.data(), packed.size(), objCompressor);
+    std::vector<char> unpacked;
+    gunzip(objz.data(), objz.size(), unpacked);
+    assert(std::string(unpacked.begin(), unpacked.end()) == text);
+
+//  a truncated buffer is an error, not a crash
+    bool thrown = false;
+    try {
+        convert.convert(stl.data(), stl.size() - 10, obj);
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    assert(thrown);
+
+    printf("Terminated successfully!\n");
+}
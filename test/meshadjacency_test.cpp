@@ -0,0 +1,77 @@
+// stl2obj converts an STL CAD file to OBJ format.
+
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cstdio>
+#include <vector>
+#include <cassert>
+#include "../src/meshadjacency.h"
+#include "../src/fillholes.h"
+
+// Unit test
+int main()
+{
+//  unit cube, outward facing, without its top (triangles 10 and 11)
+    Geometry cube;
+    for (unsigned i = 0; i < 8; i++) {
+        cube.verts_.push_back(VectorND<3, double>(double(i & 1),
+            double((i >> 1) & 1), double((i >> 2) & 1)));
+    }
+    cube.faces_ = {0, 2, 1,  1, 2, 3,      // bottom, z = 0
+                   0, 1, 4,  1, 5, 4,      // y = 0
+                   2, 6, 3,  3, 6, 7,      // y = 1
+                   0, 4, 2,  2, 4, 6,      // x = 0
+                   1, 3, 5,  3, 7, 5};     // x = 1
+
+    for (unsigned threads : {1u, 3u}) {
+        MeshAdjacency adjacency(cube.faces_, cube.verts_.size(), threads);
+        size_t boundary = 0;
+        for (size_t h = 0; h < adjacency.numOfHalfEdges(); h++) {
+            uint32_t twin = adjacency.twin(h);
+            assert(twin != MeshAdjacency::NONMANIFOLD);
+            if (twin == MeshAdjacency::BOUNDARY) {
+                boundary++;
+                continue;
+            }
+            assert(adjacency.twin(twin) == h);
+            assert(adjacency.origin(twin) == adjacency.target(h));
+            assert(adjacency.target(twin) == adjacency.origin(h));
+        }
+        assert(boundary == 4);
+        auto loops = adjacency.boundaryLoops();
+        assert(loops.size() == 1 && loops[0].size() == 4);
+        assert(adjacency.hasEdge(4, 5) && adjacency.hasEdge(5, 4));
+        assert(!adjacency.hasEdge(4, 7));
+    }
+
+//  filling closes the cube with two triangles facing up
+    FillHoles(2).fill(cube);
+    assert(cube.faces_.size() == 36);
+    MeshAdjacency closed(cube.faces_, cube.verts_.size());
+    for (size_t h = 0; h < closed.numOfHalfEdges(); h++) {
+        assert(closed.twin(h) < MeshAdjacency::NONMANIFOLD);
+    }
+    for (size_t t = 10; t < 12; t++) {
+        auto a = cube.verts_[cube.faces_[3 * t]];
+        auto b = cube.verts_[cube.faces_[3 * t + 1]];
+        auto c = cube.verts_[cube.faces_[3 * t + 2]];
+        auto u = b - a, v = c - a;
+        assert(a[2] == 1 && b[2] == 1 && c[2] == 1);
+        assert(u[0] * v[1] - u[1] * v[0] > 0);
+    }
+
+    printf("Terminated successfully!\n");
+}
@@ -0,0 +1,96 @@
+// stl2obj converts an STL CAD file to OBJ format.
+
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include <cassert>
+#include "../src/optimizecache.h"
+
+// the triangles of a mesh by the positions of their corners, each rotated
+// to start at its smallest corner, so the cyclic order is kept
+static std::vector<std::array<double, 9>> triangles(const Geometry& model)
+{
+    std::vector<std::array<double, 9>> result;
+    for (size_t f = 0; f < model.faces_.size(); f += 3) {
+        std::array<double, 3> c[3];
+        for (unsigned j = 0; j < 3; j++) {
+            Geometry::Point p = model.verts_[model.faces_[f + j]];
+            c[j] = {double(p[0]), double(p[1]), double(p[2])};
+        }
+        std::rotate(c, std::min_element(c, c + 3), c + 3);
+        std::array<double, 9> t;
+        for (unsigned j = 0; j < 3; j++) {
+            std::copy(c[j].begin(), c[j].end(), t.begin() + 3 * j);
+        }
+        result.push_back(t);
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+// Unit test
+int main()
+{
+//  a 40 x 40 grid of squares, two triangles each, in random order
+    const unsigned N = 40;
+    Geometry grid;
+    for (unsigned i = 0; i <= N; i++) {
+        for (unsigned j = 0; j <= N; j++) {
+            grid.verts_.push_back(VectorND<3, double>(double(i), double(j),
+                0.0));
+        }
+    }
+    std::vector<std::array<unsigned, 3>> tris;
+    for (unsigned i = 0; i < N; i++) {
+        for (unsigned j = 0; j < N; j++) {
+            unsigned v = i * (N + 1) + j;
+            tris.push_back({v, v + N + 1, v + 1});
+            tris.push_back({v + 1, v + N + 1, v + N + 2});
+        }
+    }
+    std::shuffle(tris.begin(), tris.end(), std::default_random_engine(0));
+    for (const auto& t : tris) {
+        grid.faces_.insert(grid.faces_.end(), t.begin(), t.end());
+    }
+
+    const size_t numOfVerts = grid.verts_.size();
+    const auto before = triangles(grid);
+    const double acmrBefore = computeACMR(grid.faces_, numOfVerts);
+    assert(acmrBefore > 1.0 && acmrBefore <= 3.0);
+
+//  the reordered mesh has the same vertices and triangles, with the same
+//  orientation, and a vertex cache loads fewer vertices per triangle
+    OptimizeVertexCache().optimize(grid);
+    assert(grid.verts_.size() == numOfVerts);
+    assert(triangles(grid) == before);
+    const double acmrAfter = computeACMR(grid.faces_, numOfVerts);
+    assert(acmrAfter <= acmrBefore);
+    assert(acmrAfter < 1.0);
+
+//  vertices are numbered in order of first use
+    unsigned next = 0;
+    for (unsigned v : grid.faces_) {
+        assert(v <= next);
+        if (v == next) next++;
+    }
+    assert(next == numOfVerts);
+
+    printf("Terminated successfully!\n");
+}
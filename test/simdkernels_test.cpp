@@ -0,0 +1,91 @@
+// stl2obj converts an STL CAD file to OBJ format.
+
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cstdio>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <cassert>
+#include "../src/vectornd.h"
+#include "../src/trianglesoup.h"
+#include "../src/simdkernels.h"
+
+// every length up to a few vector widths, so all loop tails run
+template <typename Real>
+static void testDistances(std::default_random_engine& gen)
+{
+    std::uniform_real_distribution<Real> dis(-100, 100);
+    for (size_t count = 0; count < 40; count++) {
+        std::vector<Real> x(count), y(count), z(count), out(count);
+        for (size_t i = 0; i < count; i++) {
+            x[i] = dis(gen);
+            y[i] = dis(gen);
+            z[i] = dis(gen);
+        }
+        VectorND<3, Real> p(dis(gen), dis(gen), dis(gen));
+        const Real point[3] = {p[0], p[1], p[2]};
+        distSqrBatch(x.data(), y.data(), z.data(), count, point, out.data());
+        for (size_t i = 0; i < count; i++) {
+            VectorND<3, Real> q(x[i], y[i], z[i]);
+            assert((out[i] == VectorND<3, Real>::get_dist_sqr(p, q)));
+        }
+    }
+}
+
+// Unit test
+int main()
+{
+    printf("Kernels: %s\n", simdLevel());
+    std::default_random_engine gen(0);
+    testDistances<float>(gen);
+    testDistances<double>(gen);
+
+//  bounds of STL-like records (50 bytes, corners after the normal), on odd
+//  offsets and with a NaN corner that must be ignored
+    std::uniform_real_distribution<float> dis(-100, 100);
+    const size_t numOfTris = 1001, stride = 50;
+    std::vector<char> records(numOfTris * stride + 1);
+    for (size_t t = 0; t < numOfTris; t++) {
+        for (unsigned k = 0; k < 12; k++) {
+            float v = (t == 500 && k == 7) ? NAN : dis(gen);
+            std::memcpy(&records[1 + t * stride + 4 * k], &v, sizeof(v));
+        }
+    }
+    TriangleSoup soup(records.data() + 1 + 12, stride, numOfTris);
+    for (size_t first : {0, 1, 3}) {
+        for (size_t count : {0, 1, 2, 7, 1000}) {
+            float lo[3], hi[3];
+            soup.bounds(first, count, lo, hi);
+            for (unsigned a = 0; a < 3; a++) {
+                float l = 1e30f, h = -1e30f;
+                for (size_t i = 3 * first; i < 3 * (first + count); i++) {
+                    float v = soup.corner<float>(i)[a];
+                    if (v < l) l = v;
+                    if (v > h) h = v;
+                }
+                if (count == 0) {
+                    assert(lo[a] > hi[a]);
+                } else {
+                    assert(lo[a] == l && hi[a] == h);
+                }
+            }
+        }
+    }
+
+    printf("Terminated successfully!\n");
+}
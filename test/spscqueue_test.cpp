@@ -0,0 +1,61 @@
+// stl2obj converts an STL CAD file to OBJ format.
+
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <cassert>
+#include "../src/spscqueue.h"
+
+// Unit test
+int main()
+{
+//  every item arrives once and in order, through a queue much smaller than
+//  the stream
+    const int N = 1000000;
+    SpscQueue<int> queue(5);
+    std::thread producer([&] {
+        for (int i = 0; i < N; i++) assert(queue.push(i));
+        queue.close();
+    });
+    int item, expected = 0;
+    while (queue.pop(item)) assert(item == expected++);
+    producer.join();
+    assert(expected == N);
+
+//  items pushed before the close are still delivered
+    SpscQueue<int> closing(4);
+    assert(closing.push(1) && closing.push(2));
+    closing.close();
+    assert(!closing.push(3));
+    assert(closing.pop(item) && item == 1);
+    assert(closing.pop(item) && item == 2);
+    assert(!closing.pop(item));
+
+//  a consumer that gives up releases a producer waiting on a full queue
+    SpscQueue<int> full(2);
+    std::thread blocked([&] {
+        int pushed = 0;
+        while (full.push(pushed)) pushed++;
+        assert(pushed <= 2);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    full.close();
+    blocked.join();
+
+    printf("Terminated successfully!\n");
+}
@@ -0,0 +1,117 @@
+// stl2obj converts an STL CAD file to OBJ format.
+
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include <cassert>
+#include "../src/segmentbvh.h"
+#include "../src/meshadjacency.h"
+#include "../src/stitchcurves.h"
+
+// number of boundary edges of a mesh
+static size_t boundaryEdges(const Geometry& model)
+{
+    MeshAdjacency adjacency(model.faces_, model.verts_.size());
+    size_t count = 0;
+    for (size_t h = 0; h < adjacency.numOfHalfEdges(); h++) {
+        assert(adjacency.twin(h) != MeshAdjacency::NONMANIFOLD);
+        count += (adjacency.twin(h) == MeshAdjacency::BOUNDARY);
+    }
+    return count;
+}
+
+// Unit test
+int main()
+{
+//  the hierarchy finds exactly the segments a brute force search finds
+    std::default_random_engine gen(0);
+    std::uniform_real_distribution<double> dis(0, 1);
+    std::vector<SegmentBVH<3>::Segment> segments;
+    for (uint32_t i = 0; i < 10000; i++) {
+        VectorND<> a(dis(gen), dis(gen), dis(gen));
+        VectorND<> b(a[0] + 0.02 * dis(gen), a[1] + 0.02 * dis(gen), a[2]);
+        segments.push_back(SegmentBVH<3>::Segment{a, b, i});
+    }
+    SegmentBVH<3> bvh(segments);
+    for (int i = 0; i < 1000; i++) {
+        VectorND<> p(dis(gen), dis(gen), dis(gen));
+        std::vector<char> found(segments.size(), 0);
+        size_t count = 0;
+        bvh.forEachNear(p, 0.01, [&](const SegmentBVH<3>::Segment& s,
+            double, double) {
+            assert(!found[s.id]);
+            found[s.id] = 1;
+            count++;
+        });
+        for (const auto& s : segments) {
+            double t;
+            bool near = SegmentBVH<3>::segmentDistSqr(p, s, t) <= 0.01 * 0.01;
+            assert(near == (found[s.id] != 0));
+            count -= near;
+        }
+        assert(count == 0);
+    }
+
+//  Two unit squares side by side, tessellated separately: the left one has
+//  the shared edge as one edge, the right one has a vertex in its middle
+//  (a T-junction), its lower corner is slightly off (a crack), and its
+//  upper corner was never welded.
+    Geometry model;
+    double x[] = {0, 0, 1, 0, 1, 1, 0, 1,               // left: 0..3
+                  1 + 1e-7, 0, 2, 0, 2, 1, 1, 1, 1, 0.5};  // right: 4..8
+    for (int i = 0; i < 9; i++) {
+        model.verts_.push_back(
+            VectorND<3, double>(x[2 * i], x[2 * i + 1], 0.0));
+    }
+    model.faces_ = {0, 1, 2,  0, 2, 3,
+                    4, 5, 8,  8, 5, 6,  8, 6, 7};
+    assert(boundaryEdges(model) == 4 + 5);
+
+    StitchCurves(1e-6, 2).stitch(model);
+    assert(model.verts_.size() == 7);
+    assert(model.faces_.size() == 3 * 6);
+    assert(boundaryEdges(model) == 6);
+
+//  A tall triangle over two triangles that share the middle M of its base:
+//  the split triangle is covered again without slivers, although the
+//  corner opposite the split edge is the sharpest.
+    Geometry tall;
+    double y[] = {0, 0, 1, 0, 0.5, 5, 0.5, -1, 0.5, 0};  // A B C D M
+    for (int i = 0; i < 5; i++) {
+        tall.verts_.push_back(
+            VectorND<3, double>(y[2 * i], y[2 * i + 1], 0.0));
+    }
+    tall.faces_ = {0, 1, 2,  4, 0, 3,  1, 4, 3};
+    StitchCurves(1e-6, 1).stitch(tall);
+    assert(tall.faces_.size() == 3 * 4);
+    assert(boundaryEdges(tall) == 4);
+    double total = 0.0;
+    for (size_t f = 0; f < tall.faces_.size(); f += 3) {
+        Geometry::Point a = tall.verts_[tall.faces_[f]];
+        Geometry::Point b = tall.verts_[tall.faces_[f + 1]];
+        Geometry::Point c = tall.verts_[tall.faces_[f + 2]];
+        double area = 0.5 * ((b[0] - a[0]) * (c[1] - a[1]) -
+            (b[1] - a[1]) * (c[0] - a[0]));
+        assert(area > 0.1);
+        total += area;
+    }
+    assert(std::fabs(total - 3.0) < 1e-6);
+
+    printf("Terminated successfully!\n");
+}
@@ -0,0 +1,104 @@
+// stl2obj converts an STL CAD file to OBJ format.
+
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cassert>
+#include "../src/geometry.h"
+#include "../src/streamconvert.h"
+#include "../src/weld.h"
+
+// Unit test
+int main()
+{
+//  for consistency, use the same seed
+    std::default_random_engine gen(0);
+    std::uniform_real_distribution<float> dis(-100, 100);
+    std::uniform_real_distribution<float> jitter(-1.0e-4, 1.0e-4);
+    std::uniform_int_distribution<size_t> pick;
+
+//  300000 triangles whose corners are jittered copies of 60000 points, so
+//  the copies of a point straddle the cell boundaries of a 1e-3 grid, and
+//  there are more corners than one sorted run holds
+    const uint32_t numOfTris = 300000;
+    std::vector<float> pool;
+    for (int i = 0; i < 3 * 60000; i++) pool.push_back(dis(gen));
+    std::vector<float> tris;
+    for (uint32_t i = 0; i < 3 * numOfTris; i++) {
+        size_t p = 3 * (pick(gen) % 60000);
+        for (int a = 0; a < 3; a++) tris.push_back(pool[p + a] + jitter(gen));
+    }
+
+    const char* dir = std::getenv("TMPDIR");
+    std::string base = std::string(dir ? dir : "/tmp") + "/streamconvert_test";
+    std::string input = base + ".stl", output = base + ".obj";
+    {
+        std::ofstream stl(input, std::ios::binary);
+        char header[80] = {0};
+        stl.write(header, sizeof(header));
+        stl.write((const char*)&numOfTris, sizeof(numOfTris));
+        for (uint32_t i = 0; i < numOfTris; i++) {
+            float normal[3] = {0, 0, 0};
+            stl.write((const char*)normal, sizeof(normal));
+            stl.write((const char*)&tris[9 * i], 9 * sizeof(float));
+            stl.write("\0\0", 2);
+        }
+    }
+
+//  the in-memory K-D tree welder is the reference
+    TriangleSoup soup((const char*)tris.data(), 9 * sizeof(float), numOfTris);
+    Geometry reference;
+    weldKDTree(soup, 1.0e-3, reference);
+
+    StreamConvert::Options options;
+    options.memoryBudget = 16 << 20;
+    options.tolerance = 1.0e-3;
+    StreamConvert(options).convert(input, output);
+
+//  the streaming converter numbers vertices differently, but must merge
+//  the same corners
+    size_t numOfVerts = 0;
+    std::vector<unsigned> faces;
+    std::ifstream obj(output);
+    std::string line;
+    while (std::getline(obj, line)) {
+        if (line.compare(0, 2, "v ") == 0) numOfVerts++;
+        if (line.compare(0, 2, "f ") != 0) continue;
+        std::istringstream in(line.substr(2));
+        unsigned v;
+        while (in >> v) faces.push_back(v - 1);
+    }
+    assert(numOfVerts == reference.verts_.size());
+    assert(faces.size() == reference.faces_.size());
+    std::vector<int> toStream(numOfVerts, -1), toReference(numOfVerts, -1);
+    for (size_t i = 0; i < faces.size(); i++) {
+        unsigned r = reference.faces_[i], s = faces[i];
+        if (toStream[r] < 0) toStream[r] = s;
+        if (toReference[s] < 0) toReference[s] = r;
+        assert(toStream[r] == (int)s && toReference[s] == (int)r);
+    }
+
+    std::remove(input.c_str());
+    std::remove(output.c_str());
+    printf("Terminated successfully!\n");
+}
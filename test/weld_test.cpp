@@ -0,0 +1,86 @@
+// stl2obj converts an STL CAD file to OBJ format.
+
+// Copyright (c) 2017 Amir Baserinia
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cstdio>
+#include <vector>
+#include <random>
+#include <cassert>
+#include "../src/geometry.h"
+#include "../src/weld.h"
+
+// Unit test
+int main()
+{
+//  for consistency, use the same seed
+    std::default_random_engine gen(0);
+    std::uniform_real_distribution<float> dis(-100, 100);
+    std::uniform_int_distribution<size_t> pick;
+
+//  a soup of 100000 triangles whose corners are drawn from a pool of
+//  20000 points, so every point is shared by 15 corners on average
+    std::vector<float> pool;
+    for (int i = 0; i < 3 * 20000; i++) pool.push_back(dis(gen));
+    std::vector<float> tris;
+    for (int i = 0; i < 3 * 100000; i++) {
+        size_t p = 3 * (pick(gen) % 20000);
+        tris.insert(tris.end(), &pool[p], &pool[p] + 3);
+    }
+    TriangleSoup soup((const char*)tris.data(), 9 * sizeof(float), 100000);
+
+//  the K-D tree welder is the reference
+    Geometry reference;
+    weldKDTree(soup, 1.0e-8, reference);
+
+//  the hash grid welder must reproduce it exactly
+    Geometry grid;
+    weldHashGrid(soup, 1.0e-8, grid);
+    assert(grid.faces_ == reference.faces_);
+
+//  and so must the sort welder, no matter how many threads it uses
+    for (unsigned threads : {1, 3, 8}) {
+        Geometry sorted;
+        weldSorted(soup, 1.0e-8, threads, sorted);
+        assert(sorted.faces_ == reference.faces_);
+        assert(sorted.verts_.size() == reference.verts_.size());
+        for (size_t i = 0; i < sorted.verts_.size(); i++) {
+            for (unsigned a = 0; a < 3; a++) {
+                assert(sorted.verts_[i][a] == reference.verts_[i][a]);
+            }
+        }
+    }
+
+//  jitter every corner a little; with a looser tolerance the hash grid has
+//  to find the neighbours through its cells rather than the exact bits
+    std::uniform_real_distribution<float> jitter(-1.0e-4, 1.0e-4);
+    for (auto& x : tris) x += jitter(gen);
+    Geometry looseReference, looseGrid;
+    weldKDTree(soup, 1.0e-3, looseReference);
+    weldHashGrid(soup, 1.0e-3, looseGrid);
+    assert(looseGrid.faces_ == looseReference.faces_);
+    assert(looseGrid.verts_.size() < 100000);
+
+//  the copies of a point now straddle the sort welder's cell boundaries,
+//  and it still has to merge them like the K-D tree
+    for (unsigned threads : {1, 3, 8}) {
+        Geometry looseSorted;
+        weldSorted(soup, 1.0e-3, threads, looseSorted);
+        assert(looseSorted.faces_ == looseReference.faces_);
+        assert(looseSorted.verts_.size() == looseReference.verts_.size());
+    }
+
+    printf("Terminated successfully!\n");
+}